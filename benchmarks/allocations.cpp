@@ -0,0 +1,167 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * Counts the heap allocations ( operator new calls ) per run of a chain of
+ * filters: the reset and execution cycles of Pipeline::execute(), the
+ * incremental executions without changes and Pipeline::execute( Workers& ).
+ *
+ * Usage: Tuyau-benchmark-allocations [chainLength] [options]
+ */
+
+#include "benchmark.h"
+#include "filters.h"
+
+#include <tuyau/pipeline.h>
+#include <tuyau/workers.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+namespace
+{
+std::atomic< size_t > allocations( 0 );
+
+// The replacements go through these functions, which are not inlined: GCC
+// would otherwise see the malloc and free inlined into the new and delete
+// expressions and report them as mismatched ( -Wmismatched-new-delete )
+#ifdef __GNUC__
+#  define BENCHMARK_NOINLINE __attribute__(( noinline ))
+#else
+#  define BENCHMARK_NOINLINE __declspec( noinline )
+#endif
+
+BENCHMARK_NOINLINE void* allocate( const size_t size )
+{
+    ++allocations;
+    void* memory = std::malloc( size == 0 ? 1 : size );
+    if( !memory )
+        throw std::bad_alloc();
+    return memory;
+}
+
+BENCHMARK_NOINLINE void deallocate( void* memory ) noexcept
+{
+    std::free( memory );
+}
+}
+
+// All the replaceable forms used by the library and the standard library are
+// replaced, so the allocations and deallocations match
+void* operator new( const size_t size )
+{
+    return allocate( size );
+}
+
+void* operator new[]( const size_t size )
+{
+    return allocate( size );
+}
+
+void operator delete( void* memory ) noexcept
+{
+    deallocate( memory );
+}
+
+void operator delete( void* memory, size_t ) noexcept
+{
+    deallocate( memory );
+}
+
+void operator delete[]( void* memory ) noexcept
+{
+    deallocate( memory );
+}
+
+void operator delete[]( void* memory, size_t ) noexcept
+{
+    deallocate( memory );
+}
+
+namespace
+{
+
+std::string getName( const std::string& prefix, const size_t index )
+{
+    std::stringstream name;
+    name << prefix << std::setw( 5 ) << std::setfill( '0' ) << index;
+    return name.str();
+}
+
+tuyau::Pipeline createChain( const size_t length )
+{
+    tuyau::Pipeline pipeline;
+    tuyau::PipeFilter previous = pipeline.add< benchmark::SourceFilter >( "Source" );
+    for( size_t i = 1; i < length; ++i )
+    {
+        tuyau::PipeFilter work =
+                pipeline.add< benchmark::WorkFilter >( getName( "Work", i ), size_t( 0 ));
+        previous.connect( "Out", work, "In" );
+        previous = work;
+    }
+    return pipeline;
+}
+
+/** @return the number of allocations of a run */
+template< class Func >
+double countAllocations( const Func& func )
+{
+    const size_t start = allocations;
+    func();
+    return double( allocations - start );
+}
+
+}
+
+int main( int argc, char* argv[] )
+{
+    const benchmark::Options options = benchmark::parseOptions( argc, argv );
+    const size_t length = options.get( 0, options.quick ? 100 : 1000 );
+    benchmark::Report report( "allocations", options );
+    const benchmark::Params params = benchmark::Params().add( "length", length );
+
+    tuyau::Pipeline chain = createChain( length );
+    report.measure( "resetExecute", params, "allocations", [ & ]
+    {
+        return countAllocations( [ & ]
+        {
+            chain.reset();
+            chain.execute();
+        });
+    });
+
+    report.measure( "incrementalExecute", params, "allocations", [ & ]
+    {
+        return countAllocations( [ & ]{ chain.execute(); });
+    });
+
+    tuyau::Workers workers( 1 );
+    report.measure( "resetExecuteWorkers", params, "allocations", [ & ]
+    {
+        return countAllocations( [ & ]
+        {
+            chain.reset();
+            chain.execute( workers );
+        });
+    });
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,250 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef _Benchmark_h_
+#define _Benchmark_h_
+
+#include <boost/thread/thread.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * The common harness of the benchmarks. Each measurement is repeated after a
+ * warm up run and the median, minimum and maximum are reported. The results
+ * are printed and, with --json, written as JSON for tracking the regressions
+ * between releases.
+ *
+ * Common options:
+ * --json <file>         writes the results to the file ( - for stdout )
+ * --repetitions <count> number of measured repetitions ( default 5 )
+ * --quick               reduces the problem sizes for smoke testing
+ */
+namespace benchmark
+{
+
+struct Options
+{
+    Options()
+        : repetitions( 5 )
+        , quick( false )
+    {}
+
+    size_t repetitions;
+    bool quick;
+    std::string jsonFile;
+    std::vector< std::string > arguments; // Positional arguments
+
+    /**
+     * @param index of the positional argument
+     * @param defaultValue is returned if the argument is not given
+     * @return the value of the argument
+     */
+    size_t get( const size_t index, const size_t defaultValue ) const
+    {
+        return index < arguments.size() ? std::stoul( arguments[ index ])
+                                        : defaultValue;
+    }
+};
+
+inline Options parseOptions( const int argc, char* argv[] )
+{
+    Options options;
+    for( int i = 1; i < argc; ++i )
+    {
+        const std::string argument = argv[ i ];
+        if( argument == "--json" && i + 1 < argc )
+            options.jsonFile = argv[ ++i ];
+        else if( argument == "--repetitions" && i + 1 < argc )
+            options.repetitions = std::max( 1ul, std::stoul( argv[ ++i ]));
+        else if( argument == "--quick" )
+            options.quick = true;
+        else
+            options.arguments.push_back( argument );
+    }
+    return options;
+}
+
+/** Parameters of a measurement, encoded as JSON values */
+class Params
+{
+public:
+
+    Params& add( const std::string& name, const size_t value )
+    {
+        _params.emplace_back( name, std::to_string( value ));
+        return *this;
+    }
+
+    Params& add( const std::string& name, const std::string& value )
+    {
+        _params.emplace_back( name, "\"" + value + "\"" );
+        return *this;
+    }
+
+    std::string toJSON() const
+    {
+        std::string json = "{";
+        for( size_t i = 0; i < _params.size(); ++i )
+        {
+            json += ( i > 0 ? ", \"" : "\"" ) + _params[ i ].first + "\": "
+                    + _params[ i ].second;
+        }
+        return json + "}";
+    }
+
+    std::string toString() const
+    {
+        std::string string;
+        for( const auto& param: _params )
+            string += " " + param.first + "=" + param.second;
+        return string;
+    }
+
+private:
+
+    std::vector< std::pair< std::string, std::string >> _params;
+};
+
+/** @return the duration of the function in the given unit */
+template< class Duration, class Func >
+double time( const Func& func )
+{
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const std::chrono::duration< double, typename Duration::period > elapsed =
+            std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+/** @return the thread counts from 1 to the hardware concurrency in powers of 2 */
+inline std::vector< size_t > getThreadCounts()
+{
+    const size_t maxThreads = std::max( 1u, boost::thread::hardware_concurrency( ));
+    std::vector< size_t > threadCounts;
+    for( size_t threads = 1; threads < maxThreads; threads *= 2 )
+        threadCounts.push_back( threads );
+    threadCounts.push_back( maxThreads );
+    return threadCounts;
+}
+
+class Report
+{
+public:
+
+    Report( const std::string& benchmark, const Options& options )
+        : _benchmark( benchmark )
+        , _options( options )
+    {}
+
+    ~Report()
+    {
+        if( _options.jsonFile.empty( ))
+            return;
+
+        if( _options.jsonFile == "-" )
+            write( std::cout );
+        else
+        {
+            std::ofstream file( _options.jsonFile );
+            write( file );
+        }
+    }
+
+    /**
+     * Measures a function after a warm up run.
+     * @param name of the measurement
+     * @param params of the measurement
+     * @param unit of the values returned by the function
+     * @param func runs the measured code once and returns the measured value
+     */
+    template< class Func >
+    void measure( const std::string& name,
+                  const Params& params,
+                  const std::string& unit,
+                  const Func& func )
+    {
+        func();
+        std::vector< double > values;
+        for( size_t i = 0; i < _options.repetitions; ++i )
+            values.push_back( func( ));
+        std::sort( values.begin(), values.end( ));
+
+        const Result result = { name, params, unit, values[ values.size() / 2 ],
+                                values.front(), values.back() };
+        _results.push_back( result );
+
+        if( _options.jsonFile != "-" )
+        {
+            std::cout << name << params.toString() << ": " << result.median
+                      << " " << unit << " ( min " << result.min << ", max "
+                      << result.max << " )" << std::endl;
+        }
+    }
+
+    const Options& getOptions() const { return _options; }
+
+private:
+
+    struct Result
+    {
+        std::string name;
+        Params params;
+        std::string unit;
+        double median;
+        double min;
+        double max;
+    };
+
+    void write( std::ostream& os ) const
+    {
+        os << "{\n  \"benchmark\": \"" << _benchmark << "\",\n"
+           << "  \"context\": {\"time\": " << std::time( nullptr )
+           << ", \"hardwareConcurrency\": " << boost::thread::hardware_concurrency()
+           << ", \"repetitions\": " << _options.repetitions
+           << ", \"quick\": " << ( _options.quick ? "true" : "false" ) << "},\n"
+           << "  \"results\": [";
+        for( size_t i = 0; i < _results.size(); ++i )
+        {
+            const Result& result = _results[ i ];
+            os << ( i > 0 ? ",\n" : "\n" ) << "    {\"name\": \"" << result.name
+               << "\", \"params\": " << result.params.toJSON()
+               << ", \"unit\": \"" << result.unit << "\", \"median\": "
+               << result.median << ", \"min\": " << result.min << ", \"max\": "
+               << result.max << "}";
+        }
+        os << "\n  ]\n}" << std::endl;
+    }
+
+    const std::string _benchmark;
+    const Options _options;
+    std::vector< Result > _results;
+};
+
+}
+
+#endif // _Benchmark_h_
@@ -0,0 +1,102 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * Measures the scaling of a fan-out/fan-in graph ( one producer, many
+ * workers, one consumer as in the one-to-many-to-one test pipeline ) with the
+ * number of threads, for the shared and the work stealing worker queues.
+ *
+ * Usage: Tuyau-benchmark-fanOutFanIn [width] [workIterations] [rounds] [options]
+ */
+
+#include "benchmark.h"
+#include "filters.h"
+
+#include <tuyau/pipeline.h>
+#include <tuyau/pushExecutor.h>
+
+namespace
+{
+
+tuyau::Pipeline createFanOutFanIn( const size_t width, const size_t iterations )
+{
+    tuyau::Pipeline pipeline;
+    tuyau::PipeFilter source = pipeline.add< benchmark::SourceFilter >( "Source" );
+    tuyau::PipeFilter sink = pipeline.add< benchmark::WorkFilter >( "Sink", size_t( 0 ));
+    for( size_t i = 0; i < width; ++i )
+    {
+        std::stringstream name;
+        name << "Work" << i;
+        tuyau::PipeFilter work = pipeline.add< benchmark::WorkFilter >( name.str(),
+                                                                        iterations );
+        source.connect( "Out", work, "In" );
+        work.connect( "Out", sink, "In" );
+    }
+    return pipeline;
+}
+
+double run( tuyau::Pipeline& pipeline,
+            const size_t threads,
+            const tuyau::Workers::QueueMode queueMode,
+            const size_t rounds )
+{
+    tuyau::PushExecutor executor( threads, "Benchmark", tuyau::WorkerSetupFunc(),
+                                  queueMode );
+    return benchmark::time< std::chrono::milliseconds >( [ & ]
+    {
+        for( size_t i = 0; i < rounds; ++i )
+        {
+            pipeline.reset();
+            pipeline.schedule( executor );
+            const tuyau::FutureMap sink(
+                        pipeline.getExecutable( "Sink" ).getPostconditions( ));
+            sink.wait();
+        }
+    }) / rounds;
+}
+
+}
+
+int main( int argc, char* argv[] )
+{
+    const benchmark::Options options = benchmark::parseOptions( argc, argv );
+    const size_t width = options.get( 0, 64 );
+    const size_t iterations = options.get( 1, options.quick ? 1000 : 100000 );
+    const size_t rounds = options.get( 2, options.quick ? 2 : 20 );
+    benchmark::Report report( "fanOutFanIn", options );
+
+    tuyau::Pipeline pipeline = createFanOutFanIn( width, iterations );
+    for( const size_t threads: benchmark::getThreadCounts( ))
+    {
+        benchmark::Params params = benchmark::Params()
+                .add( "width", width )
+                .add( "iterations", iterations )
+                .add( "threads", threads );
+        report.measure( "sharedQueue", params, "ms", [ & ]
+        {
+            return run( pipeline, threads, tuyau::Workers::SHARED_QUEUE, rounds );
+        });
+        report.measure( "workStealing", params, "ms", [ & ]
+        {
+            return run( pipeline, threads, tuyau::Workers::WORK_STEALING, rounds );
+        });
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,85 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef _BenchmarkFilters_h_
+#define _BenchmarkFilters_h_
+
+#include <tuyau/filter.h>
+#include <tuyau/futureMap.h>
+#include <tuyau/promiseMap.h>
+
+/** Filters for building the benchmark graphs */
+namespace benchmark
+{
+
+inline uint64_t spin( uint64_t value, const size_t iterations )
+{
+    for( size_t i = 0; i < iterations; ++i )
+        value = value * 6364136223846793005ull + 1442695040888963407ull;
+    return value;
+}
+
+/** Produces a value without inputs */
+class SourceFilter : public tuyau::Filter
+{
+    void execute( const tuyau::FutureMap&, tuyau::PromiseMap& output ) const final
+    {
+        output.set< uint64_t >( "Out", 1 );
+    }
+
+    tuyau::DataInfos getOutputDataInfos() const final
+    {
+        return {{ "Out", tuyau::getType< uint64_t >( ) }};
+    }
+};
+
+/** Spins the given number of iterations on each input */
+class WorkFilter : public tuyau::Filter
+{
+public:
+    explicit WorkFilter( const size_t iterations )
+        : _iterations( iterations )
+    {}
+
+private:
+    void execute( const tuyau::FutureMap& input, tuyau::PromiseMap& output ) const final
+    {
+        uint64_t value = 0;
+        for( const uint64_t& in: input.getValues< uint64_t >( "In" ))
+            value += spin( in, _iterations );
+        output.set( "Out", value );
+    }
+
+    tuyau::DataInfos getInputDataInfos() const final
+    {
+        return {{ "In", tuyau::getType< uint64_t >( ) }};
+    }
+
+    tuyau::DataInfos getOutputDataInfos() const final
+    {
+        return {{ "Out", tuyau::getType< uint64_t >( ) }};
+    }
+
+    const size_t _iterations;
+};
+
+}
+
+#endif // _BenchmarkFilters_h_
@@ -0,0 +1,114 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * Measures the latency of the Promise/Future operations.
+ *
+ * Usage: Tuyau-benchmark-futurePromise [iterations] [options]
+ */
+
+#include "benchmark.h"
+
+#include <tuyau/futurePromise.h>
+
+namespace
+{
+
+template< class Func >
+double measure( const size_t iterations, const Func& func )
+{
+    return benchmark::time< std::chrono::nanoseconds >( [ & ]
+    {
+        for( size_t i = 0; i < iterations; ++i )
+            func( i );
+    }) / iterations;
+}
+
+}
+
+int main( int argc, char* argv[] )
+{
+    const benchmark::Options options = benchmark::parseOptions( argc, argv );
+    const size_t iterations = options.get( 0, options.quick ? 10000 : 1000000 );
+    benchmark::Report report( "futurePromise", options );
+    const benchmark::Params params = benchmark::Params().add( "iterations", iterations );
+
+    tuyau::Promise promise( tuyau::DataInfo( "Value", tuyau::getType< size_t >( )));
+    const tuyau::Future future( promise );
+
+    size_t sum = 0;
+    report.measure( "resetSetGet", params, "ns", [ & ]
+    {
+        return measure( iterations, [ & ]( const size_t i )
+        {
+            promise.reset();
+            promise.set( i );
+            sum += future.get< size_t >();
+        });
+    });
+
+    report.measure( "isReady", params, "ns", [ & ]
+    {
+        return measure( iterations, [ & ]( const size_t )
+        {
+            sum += future.isReady();
+        });
+    });
+
+    report.measure( "copyGet", params, "ns", [ & ]
+    {
+        return measure( iterations, [ & ]( const size_t )
+        {
+            const tuyau::Future copied( future );
+            sum += copied.get< size_t >();
+        });
+    });
+
+    // Set in one thread, get in the other
+    const size_t pingPongs = iterations / 10;
+    report.measure( "crossThreadSetGet",
+                    benchmark::Params().add( "iterations", pingPongs ), "ns", [ & ]
+    {
+        tuyau::Promise pingPromise( tuyau::DataInfo( "Ping", tuyau::getType< size_t >( )));
+        tuyau::Promise pongPromise( tuyau::DataInfo( "Pong", tuyau::getType< size_t >( )));
+        const tuyau::Future ping( pingPromise );
+        const tuyau::Future pong( pongPromise );
+        boost::thread thread( [ & ]
+        {
+            for( size_t i = 0; i < pingPongs; ++i )
+            {
+                const size_t value = ping.get< size_t >();
+                pingPromise.reset();
+                pongPromise.set( value );
+            }
+        });
+
+        const double latency = measure( pingPongs, [ & ]( const size_t i )
+        {
+            pingPromise.set( i );
+            sum += pong.get< size_t >();
+            pongPromise.reset();
+        });
+        thread.join();
+        return latency;
+    });
+
+    return sum > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,86 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * Measures the throughput of MTQueue and MPMCQueue with 1 to 64 producers and
+ * the same number of consumers.
+ *
+ * Usage: Tuyau-benchmark-queue [itemsPerProducer] [options]
+ */
+
+#include "benchmark.h"
+
+#include <tuyau/mpmcQueue.h>
+#include <tuyau/mtQueue.h>
+
+namespace
+{
+
+template< class QueueT >
+double run( const size_t threads, const size_t itemsPerProducer )
+{
+    QueueT queue;
+    boost::thread_group group;
+
+    const double seconds = benchmark::time< std::chrono::seconds >( [ & ]
+    {
+        for( size_t i = 0; i < threads; ++i )
+        {
+            group.create_thread( [ &queue, itemsPerProducer ]
+            {
+                for( size_t j = 1; j <= itemsPerProducer; ++j )
+                    queue.push( j );
+            });
+
+            group.create_thread( [ &queue, itemsPerProducer ]
+            {
+                for( size_t j = 0; j < itemsPerProducer; ++j )
+                    queue.pop();
+            });
+        }
+        group.join_all();
+    });
+    return double( threads * itemsPerProducer ) / seconds;
+}
+
+}
+
+int main( int argc, char* argv[] )
+{
+    const benchmark::Options options = benchmark::parseOptions( argc, argv );
+    const size_t itemsPerProducer = options.get( 0, options.quick ? 1000 : 100000 );
+    benchmark::Report report( "queue", options );
+
+    for( size_t threads = 1; threads <= 64; threads *= 2 )
+    {
+        const benchmark::Params params = benchmark::Params()
+                .add( "producers", threads )
+                .add( "itemsPerProducer", itemsPerProducer );
+        report.measure( "MTQueue", params, "items/s", [ & ]
+        {
+            return run< tuyau::MTQueue< size_t >>( threads, itemsPerProducer );
+        });
+        report.measure( "MPMCQueue", params, "items/s", [ & ]
+        {
+            return run< tuyau::MPMCQueue< size_t >>( threads, itemsPerProducer );
+        });
+    }
+    return EXIT_SUCCESS;
+}
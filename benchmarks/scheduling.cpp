@@ -0,0 +1,205 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * Measures the scheduling overhead with empty filters: independent filters
+ * through the PushExecutor, linear chains of 1 to 10000 filters with the
+ * PushExecutor and the blocking Pipeline::execute() variants, with and
+ * without the fusion of the chain ( Pipeline::setFusion() ) and with the
+ * CriticalPathPolicy, and repeated reset()/schedule() cycles, from 1 to all
+ * threads.
+ *
+ * Usage: Tuyau-benchmark-scheduling [maxChainLength] [options]
+ */
+
+#include "benchmark.h"
+#include "filters.h"
+
+#include <tuyau/pipeline.h>
+#include <tuyau/pushExecutor.h>
+#include <tuyau/schedulingPolicy.h>
+#include <tuyau/workers.h>
+
+#include <iomanip>
+
+namespace
+{
+
+std::string getName( const std::string& prefix, const size_t index )
+{
+    std::stringstream name;
+    name << prefix << std::setw( 5 ) << std::setfill( '0' ) << index;
+    return name.str();
+}
+
+tuyau::Pipeline createIndependent( const size_t count )
+{
+    tuyau::Pipeline pipeline;
+    for( size_t i = 0; i < count; ++i )
+        pipeline.add< benchmark::SourceFilter >( getName( "Source", i ));
+    return pipeline;
+}
+
+tuyau::Pipeline createChain( const size_t length )
+{
+    tuyau::Pipeline pipeline;
+    tuyau::PipeFilter previous = pipeline.add< benchmark::SourceFilter >( "Source" );
+    for( size_t i = 1; i < length; ++i )
+    {
+        tuyau::PipeFilter work =
+                pipeline.add< benchmark::WorkFilter >( getName( "Work", i ), size_t( 0 ));
+        previous.connect( "Out", work, "In" );
+        previous = work;
+    }
+    return pipeline;
+}
+
+tuyau::Pipeline createFanOutFanIn( const size_t width )
+{
+    tuyau::Pipeline pipeline;
+    tuyau::PipeFilter source = pipeline.add< benchmark::SourceFilter >( "Source" );
+    tuyau::PipeFilter sink = pipeline.add< benchmark::WorkFilter >( "Sink", size_t( 0 ));
+    for( size_t i = 0; i < width; ++i )
+    {
+        tuyau::PipeFilter work =
+                pipeline.add< benchmark::WorkFilter >( getName( "Work", i ), size_t( 0 ));
+        source.connect( "Out", work, "In" );
+        work.connect( "Out", sink, "In" );
+    }
+    return pipeline;
+}
+
+/** @return the duration of a reset, schedule and wait round in microseconds */
+double schedule( tuyau::Pipeline& pipeline, tuyau::Executor& executor, const size_t rounds )
+{
+    return benchmark::time< std::chrono::microseconds >( [ & ]
+    {
+        for( size_t i = 0; i < rounds; ++i )
+        {
+            pipeline.reset();
+            const tuyau::FutureMap futures( pipeline.schedule( executor ));
+            futures.wait();
+        }
+    }) / rounds;
+}
+
+}
+
+int main( int argc, char* argv[] )
+{
+    const benchmark::Options options = benchmark::parseOptions( argc, argv );
+    const size_t maxChainLength = options.get( 0, options.quick ? 1000 : 10000 );
+    benchmark::Report report( "scheduling", options );
+
+    const size_t filterCount = options.quick ? 100 : 1000;
+    tuyau::Pipeline independent = createIndependent( filterCount );
+    for( const size_t threads: benchmark::getThreadCounts( ))
+    {
+        tuyau::PushExecutor executor( threads );
+        report.measure( "emptyFilter",
+                        benchmark::Params().add( "filters", filterCount )
+                                           .add( "threads", threads ),
+                        "us/filter", [ & ]
+        {
+            return schedule( independent, executor, 1 ) / filterCount;
+        });
+    }
+
+    for( size_t length = 1; length <= maxChainLength; length *= 10 )
+    {
+        tuyau::Pipeline chain = createChain( length );
+        const size_t rounds = std::max( size_t( 1 ), 1000 / length );
+        for( const size_t threads: benchmark::getThreadCounts( ))
+        {
+            const benchmark::Params params = benchmark::Params()
+                    .add( "length", length )
+                    .add( "threads", threads );
+
+            tuyau::PushExecutor executor( threads );
+            report.measure( "chainPushExecutor", params, "us", [ & ]
+            {
+                return schedule( chain, executor, rounds );
+            });
+
+            tuyau::Workers workers( threads );
+            const auto executeWorkers = [ & ]
+            {
+                return benchmark::time< std::chrono::microseconds >( [ & ]
+                {
+                    for( size_t i = 0; i < rounds; ++i )
+                    {
+                        chain.reset();
+                        chain.execute( workers );
+                    }
+                }) / rounds;
+            };
+            report.measure( "chainExecuteWorkers", params, "us", executeWorkers );
+
+            // The chain is executed back to back by a single worker
+            chain.setFusion( true );
+            report.measure( "chainPushExecutorFused", params, "us", [ & ]
+            {
+                return schedule( chain, executor, rounds );
+            });
+            report.measure( "chainExecuteWorkersFused", params, "us", executeWorkers );
+            chain.setFusion( false );
+        }
+
+        // The ranks of the critical path are kept across the executions, so
+        // the cost per filter does not grow with the length of the chain
+        tuyau::PushExecutor criticalPathExecutor( 1 );
+        criticalPathExecutor.setSchedulingPolicy(
+                    std::make_shared< tuyau::CriticalPathPolicy >( ));
+        report.measure( "chainCriticalPath", benchmark::Params().add( "length", length ),
+                        "us/filter", [ & ]
+        {
+            return schedule( chain, criticalPathExecutor, rounds ) / length;
+        });
+
+        report.measure( "chainExecute", benchmark::Params().add( "length", length ), "us", [ & ]
+        {
+            return benchmark::time< std::chrono::microseconds >( [ & ]
+            {
+                for( size_t i = 0; i < rounds; ++i )
+                {
+                    chain.reset();
+                    chain.execute();
+                }
+            }) / rounds;
+        });
+    }
+
+    const size_t width = 10;
+    const size_t cycles = options.quick ? 100 : 1000;
+    tuyau::Pipeline fan = createFanOutFanIn( width );
+    for( const size_t threads: benchmark::getThreadCounts( ))
+    {
+        tuyau::PushExecutor executor( threads );
+        report.measure( "resetReschedule",
+                        benchmark::Params().add( "width", width )
+                                           .add( "cycles", cycles )
+                                           .add( "threads", threads ),
+                        "us/cycle", [ & ]
+        {
+            return schedule( fan, executor, cycles );
+        });
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,72 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+
+#define BOOST_TEST_MODULE Arena
+
+#include <tuyau/arena.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_CASE( testArenaAllocation )
+{
+    tuyau::Arena arena( 64 );
+    BOOST_CHECK_EQUAL( arena.getCapacity(), 0 );
+
+    char* first = static_cast< char* >( arena.allocate( 1, 1 ));
+    void* aligned = arena.allocate( 8, 8 );
+    BOOST_CHECK_EQUAL( reinterpret_cast< uintptr_t >( aligned ) % 8, 0 );
+    BOOST_CHECK_EQUAL( static_cast< char* >( aligned ) - first, 8 );
+
+    // The objects larger than the chunks get their own chunk
+    arena.allocate( 100, 16 );
+    BOOST_CHECK_GE( arena.getCapacity(), 64 + 100 );
+
+    // The chunks are coalesced into one, which fits the next run
+    const size_t capacity = arena.getCapacity();
+    arena.release();
+    BOOST_CHECK_EQUAL( arena.getCapacity(), capacity );
+    arena.allocate( 1, 1 );
+    arena.allocate( capacity - 16, 8 );
+    BOOST_CHECK_EQUAL( arena.getCapacity(), capacity );
+}
+
+BOOST_AUTO_TEST_CASE( testArenaAllocator )
+{
+    typedef std::vector< size_t, tuyau::ArenaAllocator< size_t >> Values;
+
+    tuyau::Arena arena;
+    const tuyau::ArenaAllocator< size_t > allocator( arena );
+    for( size_t run = 0; run < 3; ++run )
+    {
+        Values values( allocator );
+        for( size_t i = 0; i < 1000; ++i )
+            values.push_back( i );
+        BOOST_CHECK_EQUAL( values[ 999 ], 999 );
+        arena.release();
+    }
+
+    // The growth of the vectors in the first run sized the arena
+    const size_t capacity = arena.getCapacity();
+    const Values values( 1000, 0, allocator );
+    BOOST_CHECK_EQUAL( arena.getCapacity(), capacity );
+}
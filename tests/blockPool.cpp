@@ -0,0 +1,86 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#define BOOST_TEST_MODULE BlockPool
+
+#include <tuyau/blockPool.h>
+#include <tuyau/futurePromise.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_CASE( testPromiseResetReuse )
+{
+    tuyau::Promise promise( tuyau::DataInfo( "Value", tuyau::getType< uint32_t >( )));
+    const tuyau::Future future( promise );
+
+    // The port data and the states of the promise values are recycled
+    for( uint32_t i = 0; i < 10; ++i )
+    {
+        promise.reset();
+        promise.set( i );
+    }
+
+    const size_t allocated = tuyau::BlockPool::getAllocatedBlocks();
+    for( uint32_t i = 0; i < 1000; ++i )
+    {
+        promise.reset();
+        promise.set( i );
+        BOOST_CHECK_EQUAL( future.get< uint32_t >(), i );
+    }
+    BOOST_CHECK_EQUAL( tuyau::BlockPool::getAllocatedBlocks(), allocated );
+}
+
+BOOST_AUTO_TEST_CASE( testCrossThreadReuse )
+{
+    const size_t blockSize = 48;
+    const size_t count = 1000;
+
+    // The blocks allocated in one thread and freed in the other are reused
+    const auto allocateAndFree = [ & ]
+    {
+        std::vector< void* > blocks;
+        boost::thread producer( [ & ]
+        {
+            for( size_t i = 0; i < count; ++i )
+                blocks.push_back( tuyau::BlockPool::allocate( blockSize ));
+        });
+        producer.join();
+
+        for( void* block: blocks )
+            tuyau::BlockPool::deallocate( block, blockSize );
+    };
+
+    allocateAndFree();
+    size_t allocated = tuyau::BlockPool::getAllocatedBlocks();
+    allocateAndFree();
+
+    // Only the blocks, which are still cached by the freeing thread, are not
+    // reused
+    BOOST_CHECK_LT( tuyau::BlockPool::getAllocatedBlocks() - allocated, count / 10 );
+    allocated = tuyau::BlockPool::getAllocatedBlocks();
+
+    // The large blocks are not pooled
+    void* large = tuyau::BlockPool::allocate( tuyau::BlockPool::maxBlockSize + 1 );
+    tuyau::BlockPool::deallocate( large, tuyau::BlockPool::maxBlockSize + 1 );
+    BOOST_CHECK_EQUAL( tuyau::BlockPool::getAllocatedBlocks(), allocated );
+}
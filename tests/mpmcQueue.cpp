@@ -0,0 +1,75 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define BOOST_TEST_MODULE MPMCQueue
+
+#include <tuyau/mpmcQueue.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <atomic>
+
+BOOST_AUTO_TEST_CASE( testFifoOrder )
+{
+    tuyau::MPMCQueue< size_t, 4 > queue;
+    BOOST_CHECK( queue.isEmpty( ));
+
+    for( size_t i = 0; i < 4; ++i )
+        BOOST_CHECK( queue.tryPush( i ));
+
+    // The queue is bounded
+    BOOST_CHECK( !queue.tryPush( 4 ));
+    BOOST_CHECK_EQUAL( queue.getSize(), 4 );
+
+    for( size_t i = 0; i < 4; ++i )
+        BOOST_CHECK_EQUAL( queue.pop(), i );
+
+    size_t value = 0;
+    BOOST_CHECK( !queue.tryPop( value ));
+    BOOST_CHECK( !queue.timedPop( 10, value ));
+}
+
+BOOST_AUTO_TEST_CASE( testProducersConsumers )
+{
+    const size_t threads = 4;
+    const size_t itemsPerProducer = 10000;
+
+    tuyau::MPMCQueue< size_t, 64 > queue;
+    std::atomic< size_t > sum( 0 );
+    boost::thread_group group;
+    for( size_t i = 0; i < threads; ++i )
+    {
+        group.create_thread( [ & ]
+        {
+            for( size_t j = 1; j <= itemsPerProducer; ++j )
+                queue.push( j );
+        });
+
+        group.create_thread( [ & ]
+        {
+            for( size_t j = 0; j < itemsPerProducer; ++j )
+                sum += queue.pop();
+        });
+    }
+    group.join_all();
+
+    BOOST_CHECK( queue.isEmpty( ));
+    BOOST_CHECK_EQUAL( sum, threads * itemsPerProducer * ( itemsPerProducer + 1 ) / 2 );
+}
@@ -0,0 +1,223 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+
+#define BOOST_TEST_MODULE Parallel
+
+#include <tuyau/parallel.h>
+#include <tuyau/workers.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+/** @return the result of the function executed on the workers */
+template< class T, class Func >
+T executeOn( tuyau::Workers& workers, const Func& func )
+{
+    std::promise< T > result;
+    workers.submit( [ & ]
+    {
+        try
+        {
+            result.set_value( func( ));
+        }
+        catch( ... )
+        {
+            result.set_exception( std::current_exception( ));
+        }
+    });
+    return result.get_future().get();
+}
+
+}
+
+BOOST_AUTO_TEST_CASE( testParallelForOutOfWorkers )
+{
+    // The iterations are executed by the calling thread in one chunk
+    BOOST_CHECK( !tuyau::Workers::getCurrent( ));
+    BOOST_CHECK_EQUAL( tuyau::getChunkCount( 100 ), 1 );
+    BOOST_CHECK_EQUAL( tuyau::getChunkCount( 0 ), 0 );
+
+    size_t calls = 0;
+    tuyau::parallelFor( 10, 20, [ & ]( const size_t begin, const size_t end )
+    {
+        BOOST_CHECK_EQUAL( begin, 10 );
+        BOOST_CHECK_EQUAL( end, 20 );
+        ++calls;
+    });
+    BOOST_CHECK_EQUAL( calls, 1 );
+}
+
+BOOST_AUTO_TEST_CASE( testParallelFor )
+{
+    tuyau::Workers workers( 4 );
+    const size_t size = 10000;
+    std::vector< std::atomic< size_t >> visits( size );
+    for( auto& visit: visits )
+        visit = 0;
+
+    const size_t nChunks = executeOn< size_t >( workers, [ & ]
+    {
+        BOOST_CHECK_EQUAL( tuyau::Workers::getCurrent(), &workers );
+
+        std::atomic< size_t > chunks( 0 );
+        tuyau::parallelFor( 0, size, [ & ]( const size_t begin, const size_t end )
+        {
+            for( size_t i = begin; i < end; ++i )
+                ++visits[ i ];
+            ++chunks;
+        });
+        return chunks.load();
+    });
+
+    // A few chunks per thread
+    BOOST_CHECK_EQUAL( nChunks, 16 );
+    for( const auto& visit: visits )
+        BOOST_CHECK_EQUAL( visit, 1 );
+
+    // The grain size bounds the chunks
+    const size_t grainChunks = executeOn< size_t >( workers, []
+    {
+        return tuyau::getChunkCount( 1000, 300 );
+    });
+    BOOST_CHECK_EQUAL( grainChunks, 4 );
+}
+
+BOOST_AUTO_TEST_CASE( testParallelReduce )
+{
+    for( const size_t nThreads: { 1, 2, 4 })
+    {
+        // The caller helps, so the nested loops do not wait for free threads
+        tuyau::Workers workers( nThreads );
+        const uint64_t sum = executeOn< uint64_t >( workers, []
+        {
+            return tuyau::parallelReduce( size_t( 0 ), size_t( 100 ), uint64_t( 0 ),
+                [ & ]( const size_t begin, const size_t end )
+                {
+                    return tuyau::parallelReduce( begin * 100, end * 100, uint64_t( 0 ),
+                        []( const size_t first, const size_t last )
+                        {
+                            uint64_t partial = 0;
+                            for( size_t i = first; i < last; ++i )
+                                partial += i;
+                            return partial;
+                        },
+                        std::plus< uint64_t >( ));
+                },
+                std::plus< uint64_t >( ));
+        });
+        BOOST_CHECK_EQUAL( sum, 49995000u );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( testParallelRanges )
+{
+    typedef std::pair< size_t, size_t > Range;
+    const auto rangeSize = []( const size_t begin, const size_t end )
+    {
+        return uint64_t( end - begin );
+    };
+
+    // The empty and reversed ranges have no iterations, out of the workers, too
+    std::atomic< size_t > calls( 0 );
+    const auto call = [ & ]( const size_t, const size_t ) { ++calls; };
+    tuyau::parallelFor( 20, 10, call );
+    BOOST_CHECK_EQUAL( tuyau::parallelReduce( size_t( 20 ), size_t( 10 ), uint64_t( 7 ),
+                                              rangeSize, std::plus< uint64_t >( )), 7 );
+
+    tuyau::Workers workers( 4 );
+    const size_t largeBegin = 10;
+    const size_t largeEnd = std::numeric_limits< size_t >::max();
+    std::mutex mutex;
+    std::vector< Range > ranges;
+    std::vector< uint64_t > sizes;
+    executeOn< bool >( workers, [ & ]
+    {
+        tuyau::parallelFor( 10, 10, call );
+        tuyau::parallelFor( 20, 10, call );
+        sizes.push_back( tuyau::parallelReduce( size_t( 10 ), size_t( 10 ), uint64_t( 7 ),
+                                                rangeSize, std::plus< uint64_t >( )));
+        sizes.push_back( tuyau::parallelReduce( size_t( 20 ), size_t( 10 ), uint64_t( 7 ),
+                                                rangeSize, std::plus< uint64_t >( )));
+
+        // The chunks of a large range do not overflow
+        tuyau::parallelFor( largeBegin, largeEnd, [ & ]( const size_t begin,
+                                                         const size_t end )
+        {
+            std::lock_guard< std::mutex > lock( mutex );
+            ranges.push_back( Range( begin, end ));
+        });
+        sizes.push_back( tuyau::parallelReduce( largeBegin, largeEnd, uint64_t( 0 ),
+                                                rangeSize, std::plus< uint64_t >( )));
+        return true;
+    });
+
+    BOOST_CHECK_EQUAL( calls, 0 );
+    const std::vector< uint64_t > expectedSizes = { 7, 7, largeEnd - largeBegin };
+    BOOST_CHECK_EQUAL_COLLECTIONS( sizes.begin(), sizes.end(),
+                                   expectedSizes.begin(), expectedSizes.end( ));
+
+    // The chunks cover the range in order, with sizes differing by one at most
+    std::sort( ranges.begin(), ranges.end( ));
+    BOOST_REQUIRE_EQUAL( ranges.size(), 17 );
+    BOOST_CHECK_EQUAL( ranges.front().first, largeBegin );
+    BOOST_CHECK_EQUAL( ranges.back().second, largeEnd );
+    for( size_t i = 0; i < ranges.size(); ++i )
+    {
+        BOOST_CHECK_LT( ranges[ i ].first, ranges[ i ].second );
+        if( i > 0 )
+            BOOST_CHECK_EQUAL( ranges[ i ].first, ranges[ i - 1 ].second );
+
+        const size_t size = ranges[ i ].second - ranges[ i ].first;
+        const size_t frontSize = ranges.front().second - ranges.front().first;
+        BOOST_CHECK_LE( frontSize - size, 1 );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( testParallelForException )
+{
+    tuyau::Workers workers( 2 );
+    std::atomic< size_t > finished( 0 );
+    BOOST_CHECK_THROW( executeOn< bool >( workers, [ & ]
+    {
+        tuyau::parallelFor( 0, 8, [ & ]( const size_t begin, const size_t )
+        {
+            if( begin == 0 )
+                throw std::runtime_error( "Chunk failed" );
+            ++finished;
+        }, 1 );
+        return true;
+    }), std::runtime_error );
+
+    // The other chunks are finished before the exception is thrown
+    BOOST_CHECK_EQUAL( finished, 7 );
+}
@@ -19,10 +19,14 @@
 
 #define BOOST_TEST_MODULE Pipeline
 
+#include <tuyau/asyncFilter.h>
 #include <tuyau/pipeFilter.h>
 #include <tuyau/filter.h>
 #include <tuyau/pipeline.h>
+#include <tuyau/pipelineStream.h>
 #include <tuyau/pushExecutor.h>
+#include <tuyau/schedulingPolicy.h>
+#include <tuyau/splitFilter.h>
 #include <tuyau/workers.h>
 #include <tuyau/futureMap.h>
 #include <tuyau/promiseMap.h>
@@ -30,6 +34,18 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <numeric>
+#include <thread>
+#include <unordered_set>
+
+#ifdef __linux__
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
 namespace ut = boost::unit_test;
 
 const uint32_t defaultMeaningOfLife = 42;
@@ -108,6 +124,417 @@ class ConvertFilter : public tuyau::Filter
     }
 };
 
+class HandleConvertFilter : public tuyau::Filter
+{
+public:
+
+    HandleConvertFilter()
+        : _input( getInputHandle( "ConvertInputData" ))
+        , _output( getOutputHandle( "ConvertOutputData" ))
+    {}
+
+    void execute( const tuyau::FutureMap& input, tuyau::PromiseMap& output ) const final
+    {
+        InputData inputData;
+        for( const auto& future: input.getFutures( _input ))
+        {
+            const OutputData& data = future.get< OutputData >();
+            inputData.meaningOfLife = data.thanksForAllTheFish + addMoreFish;
+        }
+
+        output.set( _output, inputData );
+    }
+
+    tuyau::DataInfos getInputDataInfos() const final
+    {
+        return {{ "ConvertInputData", tuyau::getType< OutputData >( ) }};
+    }
+
+    tuyau::DataInfos getOutputDataInfos() const final
+    {
+        return {{ "ConvertOutputData", tuyau::getType< InputData >( )}};
+    }
+
+private:
+
+    const tuyau::PortHandle _input;
+    const tuyau::PortHandle _output;
+};
+
+class FutureNameFilter : public tuyau::Filter
+{
+public:
+
+    void execute( const tuyau::FutureMap& input, tuyau::PromiseMap& output ) const final
+    {
+        names.clear();
+        for( const auto& future: input.getFutures( ))
+            names.push_back( future.getName( ));
+
+        size_t sum = 0;
+        for( const OutputData& data: input.getValues< OutputData >( "NameInputData" ))
+            sum += data.thanksForAllTheFish;
+        output.set( "NameOutputData", InputData( sum ));
+    }
+
+    tuyau::DataInfos getInputDataInfos() const final
+    {
+        return {{ "NameInputData", tuyau::getType< OutputData >( ) }};
+    }
+
+    tuyau::DataInfos getOutputDataInfos() const final
+    {
+        return {{ "NameOutputData", tuyau::getType< InputData >( )}};
+    }
+
+    static std::vector< std::string > names;
+};
+
+std::vector< std::string > FutureNameFilter::names;
+
+class ValueRangeFilter : public tuyau::Filter
+{
+public:
+
+    ValueRangeFilter()
+        : _input( getInputHandle( "TestInputData" ))
+    {}
+
+    void execute( const tuyau::FutureMap& input, tuyau::PromiseMap& output ) const final
+    {
+        const tuyau::ValueRange< InputData > values = input.getValues< InputData >( _input );
+        std::vector< uint32_t > meaningsOfLife;
+        for( auto it = values.begin(); it != values.end(); it++ )
+            meaningsOfLife.push_back( it->meaningOfLife );
+
+        output.set( "Values", meaningsOfLife );
+    }
+
+    tuyau::DataInfos getInputDataInfos() const final
+    {
+        return {{ "TestInputData", tuyau::getType< InputData >( ) }};
+    }
+
+    tuyau::DataInfos getOutputDataInfos() const final
+    {
+        return {{ "Values", tuyau::getType< std::vector< uint32_t >>( )}};
+    }
+
+private:
+
+    const tuyau::PortHandle _input;
+};
+
+class PureFilter : public tuyau::Filter
+{
+public:
+
+    static std::atomic< size_t > executions;
+
+private:
+
+    void execute( const tuyau::FutureMap& input, tuyau::PromiseMap& output ) const final
+    {
+        ++executions;
+        uint32_t value = 0;
+        for( const uint32_t& inputValue: input.getValues< uint32_t >( "PureInputData" ))
+            value += 2 * inputValue;
+        output.set( "PureOutputData", value );
+    }
+
+    tuyau::DataInfos getInputDataInfos() const final
+    {
+        return {{ "PureInputData", tuyau::getType< uint32_t >( ) }};
+    }
+
+    tuyau::DataInfos getOutputDataInfos() const final
+    {
+        return {{ "PureOutputData", tuyau::getType< uint32_t >( )}};
+    }
+
+    bool isPure() const final { return true; }
+};
+
+std::atomic< size_t > PureFilter::executions( 0 );
+
+class FailingFilter : public tuyau::Filter
+{
+public:
+
+    static std::atomic< size_t > failures;
+
+private:
+
+    void execute( const tuyau::FutureMap& input, tuyau::PromiseMap& output ) const final
+    {
+        if( failures > 0 )
+        {
+            --failures;
+            throw std::bad_alloc();
+        }
+        output.set( "PureOutputData", 2 * input.get< uint32_t >( "PureInputData" ).front( ));
+    }
+
+    tuyau::DataInfos getInputDataInfos() const final
+    {
+        return {{ "PureInputData", tuyau::getType< uint32_t >( ) }};
+    }
+
+    tuyau::DataInfos getOutputDataInfos() const final
+    {
+        return {{ "PureOutputData", tuyau::getType< uint32_t >( )}};
+    }
+};
+
+std::atomic< size_t > FailingFilter::failures( 0 );
+
+struct CollidingData
+{
+    bool operator==( const CollidingData& rhs ) const { return value == rhs.value; }
+    uint32_t value;
+};
+
+namespace tuyau
+{
+template<>
+struct DataHash< CollidingData >
+{
+    static const bool enabled = true;
+    size_t operator()( const CollidingData& ) const { return 0; }
+};
+}
+
+class CollidingFilter : public tuyau::Filter
+{
+    void execute( const tuyau::FutureMap& input, tuyau::PromiseMap& output ) const final
+    {
+        output.set( "CollidingOutputData",
+                    2 * input.get< CollidingData >( "CollidingInputData" ).front().value );
+    }
+
+    tuyau::DataInfos getInputDataInfos() const final
+    {
+        return {{ "CollidingInputData", tuyau::getType< CollidingData >( ) }};
+    }
+
+    tuyau::DataInfos getOutputDataInfos() const final
+    {
+        return {{ "CollidingOutputData", tuyau::getType< uint32_t >( )}};
+    }
+
+    bool isPure() const final { return true; }
+};
+
+/** Declares a large output and records the number of concurrent executions */
+class LargeOutputFilter : public tuyau::Filter
+{
+public:
+
+    static std::atomic< size_t > running;
+    static std::atomic< size_t > maxRunning;
+
+private:
+
+    void execute( const tuyau::FutureMap& input, tuyau::PromiseMap& output ) const final
+    {
+        const size_t current = ++running;
+        size_t max = maxRunning;
+        while( current > max && !maxRunning.compare_exchange_weak( max, current ))
+            ;
+
+        std::this_thread::sleep_for( std::chrono::milliseconds( 5 ));
+        output.set( "PureOutputData", 2 * input.get< uint32_t >( "PureInputData" ).front( ));
+        --running;
+    }
+
+    tuyau::DataInfos getInputDataInfos() const final
+    {
+        return {{ "PureInputData", tuyau::getType< uint32_t >( ) }};
+    }
+
+    tuyau::DataInfos getOutputDataInfos() const final
+    {
+        return {{ "PureOutputData", tuyau::getType< uint32_t >( )}};
+    }
+
+    size_t getEstimatedOutputSize() const final { return 100; }
+};
+
+std::atomic< size_t > LargeOutputFilter::running( 0 );
+std::atomic< size_t > LargeOutputFilter::maxRunning( 0 );
+
+/** Records the order of the executions */
+class OrderFilter : public tuyau::Filter
+{
+public:
+
+    explicit OrderFilter( const std::string& name )
+        : _name( name )
+    {}
+
+    static std::vector< std::string > order;
+
+private:
+
+    void execute( const tuyau::FutureMap&, tuyau::PromiseMap& output ) const final
+    {
+        order.push_back( _name );
+        output.set( "PureOutputData", 0u );
+    }
+
+    tuyau::DataInfos getInputDataInfos() const final
+    {
+        return {{ "PureInputData", tuyau::getType< uint32_t >( ) }};
+    }
+
+    tuyau::DataInfos getOutputDataInfos() const final
+    {
+        return {{ "PureOutputData", tuyau::getType< uint32_t >( )}};
+    }
+
+    const std::string _name;
+};
+
+std::vector< std::string > OrderFilter::order;
+
+/** Waits for a gate and an asynchronous operation before setting its output */
+class AsyncGateFilter : public tuyau::AsyncFilter
+{
+public:
+
+    explicit AsyncGateFilter( const tuyau::Future& gate )
+        : _gate( gate )
+    {}
+
+private:
+
+    void execute( const tuyau::FutureMap& input, tuyau::PromiseMap& output ) const final
+    {
+        await( input, "PureInputData" );
+        await( _gate );
+
+        uint32_t result = 0;
+        await( [ & ]( const tuyau::WorkerTask& resume )
+        {
+            std::thread( [ &result, resume ]
+            {
+                result = 1;
+                resume();
+            }).detach();
+        });
+
+        output.set( "PureOutputData",
+                    input.get< uint32_t >( "PureInputData" ).front() + _gate.get< uint32_t >()
+                    + result );
+    }
+
+    tuyau::DataInfos getInputDataInfos() const final
+    {
+        return {{ "PureInputData", tuyau::getType< uint32_t >( ) }};
+    }
+
+    tuyau::DataInfos getOutputDataInfos() const final
+    {
+        return {{ "PureOutputData", tuyau::getType< uint32_t >( )}};
+    }
+
+    const tuyau::Future _gate;
+};
+
+/** Opens the gate of the AsyncGateFilter */
+class GateFilter : public tuyau::Filter
+{
+public:
+
+    explicit GateFilter( const tuyau::Promise& gate )
+        : _gate( gate )
+    {}
+
+private:
+
+    void execute( const tuyau::FutureMap& input, tuyau::PromiseMap& output ) const final
+    {
+        tuyau::Promise gate = _gate;
+        gate.set( input.get< uint32_t >( "PureInputData" ).front( ));
+        output.set( "PureOutputData", 0u );
+    }
+
+    tuyau::DataInfos getInputDataInfos() const final
+    {
+        return {{ "PureInputData", tuyau::getType< uint32_t >( ) }};
+    }
+
+    tuyau::DataInfos getOutputDataInfos() const final
+    {
+        return {{ "PureOutputData", tuyau::getType< uint32_t >( )}};
+    }
+
+    const tuyau::Promise _gate;
+};
+
+/** Sums the values in chunks */
+class SumFilter : public tuyau::SplitFilter
+{
+public:
+
+    /** @param nChunks is the number of chunks, 0 for the number of threads */
+    explicit SumFilter( const size_t nChunks = 0 )
+        : _nChunks( nChunks )
+    {}
+
+    static std::atomic< size_t > chunks;
+
+private:
+
+    size_t split( const tuyau::FutureMap&, const size_t maxChunks ) const final
+    {
+        return _nChunks ? _nChunks : maxChunks;
+    }
+
+    void executeChunk( const tuyau::FutureMap& input,
+                       const size_t chunk,
+                       const size_t nChunks,
+                       tuyau::PromiseMap& output ) const final
+    {
+        const std::vector< uint32_t >& values =
+                *input.getValues< std::vector< uint32_t >>( "Values" ).begin();
+        const size_t begin = values.size() * chunk / nChunks;
+        const size_t end = values.size() * ( chunk + 1 ) / nChunks;
+        output.set( "PartialSum", std::accumulate( values.begin() + begin,
+                                                   values.begin() + end, 0u ));
+        ++chunks;
+    }
+
+    void merge( const tuyau::FutureMap&,
+                const std::vector< tuyau::FutureMap >& chunkOutputs,
+                tuyau::PromiseMap& output ) const final
+    {
+        uint32_t sum = 0;
+        for( const tuyau::FutureMap& chunkOutput: chunkOutputs )
+            sum += chunkOutput.get< uint32_t >( "PartialSum" ).front();
+        output.set( "Sum", sum );
+    }
+
+    tuyau::DataInfos getInputDataInfos() const final
+    {
+        return {{ "Values", tuyau::getType< std::vector< uint32_t >>( ) }};
+    }
+
+    tuyau::DataInfos getOutputDataInfos() const final
+    {
+        return {{ "Sum", tuyau::getType< uint32_t >( )}};
+    }
+
+    tuyau::DataInfos getChunkDataInfos() const final
+    {
+        return {{ "PartialSum", tuyau::getType< uint32_t >( )}};
+    }
+
+    const size_t _nChunks;
+};
+
+std::atomic< size_t > SumFilter::chunks( 0 );
+
 bool check_error( const std::runtime_error& ) { return true; }
 
 BOOST_AUTO_TEST_CASE( testFilterNoInput )
@@ -122,6 +549,22 @@ BOOST_AUTO_TEST_CASE( testFilterNoInput )
     BOOST_CHECK_THROW( portFutures.get< OutputData >( "TestOutputData" ), std::runtime_error );
 }
 
+BOOST_AUTO_TEST_CASE( testFailedExecution )
+{
+    // A failed execution is not recorded, whatever the exception type, so the
+    // next execution runs the filter again
+    tuyau::Pipeline pipeline;
+    tuyau::PipeFilter pipeFilter = pipeline.add< FailingFilter >( "Failing" );
+    pipeFilter.getPromise( "PureInputData" ).set( 1u );
+
+    FailingFilter::failures = 1;
+    BOOST_CHECK_THROW( pipeline.execute(), std::bad_alloc );
+
+    pipeline.execute();
+    BOOST_CHECK_EQUAL( FailingFilter::failures, 0 );
+    BOOST_CHECK_EQUAL( pipeFilter.getPostconditions().front().get< uint32_t >(), 2 );
+}
+
 BOOST_AUTO_TEST_CASE( testFilterWithInput )
 {
     tuyau::PipeFilterT< TestFilter > pipeFilter( "Producer" );
@@ -180,18 +623,88 @@ BOOST_AUTO_TEST_CASE( testConnection )
     BOOST_CHECK_EQUAL( outputData.thanksForAllTheFish, 222 );
 }
 
-tuyau::Pipeline createPipeline( const uint32_t inputValue,
-                                size_t nConvertFilter = 1 )
+BOOST_AUTO_TEST_CASE( testPortHandles )
 {
-    tuyau::Pipeline pipeline;
-    tuyau::PipeFilter pipeInput = pipeline.add< TestFilter >( "Producer" );
-    tuyau::PipeFilter pipeOutput = pipeline.add< TestFilter >( "Consumer" );
+    tuyau::PipeFilterT< TestFilter > pipeInput( "Producer" );
+    tuyau::PipeFilterT< TestFilter > pipeOutput( "Consumer" );
+    tuyau::PipeFilterT< HandleConvertFilter > convertPipeFilter( "Converter" );
 
-    for( size_t i = 0; i < nConvertFilter; ++i )
+    pipeInput.connect( "TestOutputData", convertPipeFilter, "ConvertInputData" );
+    convertPipeFilter.connect( "ConvertOutputData", pipeOutput, "TestInputData" );
+
+    for( const uint32_t inputValue: { 90u, 100u })
     {
-        std::stringstream name;
-        name << "Converter" << i;
-        tuyau::PipeFilter convertPipeFilter =
+        pipeInput.reset();
+        convertPipeFilter.reset();
+        pipeOutput.reset();
+
+        pipeInput.getPromise( "TestInputData" ).set( InputData( inputValue ));
+        pipeInput.execute();
+        convertPipeFilter.execute();
+        pipeOutput.execute();
+
+        const tuyau::UniqueFutureMap portFutures( pipeOutput.getPostconditions( ));
+        const OutputData& outputData =
+                portFutures.get< OutputData >( "TestOutputData" );
+        BOOST_CHECK_EQUAL( outputData.thanksForAllTheFish, inputValue + 132 );
+    }
+
+    const HandleConvertFilter filter;
+    BOOST_CHECK_THROW( filter.getInputHandle( "ConvertOutputData" ), std::logic_error );
+    BOOST_CHECK_THROW( filter.getOutputHandle( "Unknown" ), std::logic_error );
+
+    const tuyau::FutureMap futures( tuyau::Futures{} );
+    BOOST_CHECK_THROW( futures.getFutures( tuyau::PortHandle( 0 )), std::logic_error );
+}
+
+BOOST_AUTO_TEST_CASE( testInputFutureNames )
+{
+    tuyau::PipeFilterT< TestFilter > producer1( "Producer1" );
+    tuyau::PipeFilterT< TestFilter > producer2( "Producer2" );
+    tuyau::PipeFilterT< FutureNameFilter > consumer( "Consumer" );
+    producer1.connect( "TestOutputData", consumer, "NameInputData" );
+
+    // The input futures are named with the input port, not the output port,
+    // across resets and connection changes
+    for( size_t nProducers: { 1, 1, 2 })
+    {
+        if( nProducers == 2 )
+            producer2.connect( "TestOutputData", consumer, "NameInputData" );
+
+        producer1.reset();
+        producer2.reset();
+        consumer.reset();
+
+        producer1.getPromise( "TestInputData" ).set( InputData( 0 ));
+        producer2.getPromise( "TestInputData" ).set( InputData( 10 ));
+        producer1.execute();
+        producer2.execute();
+        consumer.execute();
+
+        const std::vector< std::string > names( nProducers, "NameInputData" );
+        BOOST_CHECK_EQUAL_COLLECTIONS( FutureNameFilter::names.begin(),
+                                       FutureNameFilter::names.end(),
+                                       names.begin(), names.end( ));
+
+        const tuyau::UniqueFutureMap portFutures( consumer.getPostconditions( ));
+        const uint32_t expected = nProducers == 1 ? 61 : 61 + 71;
+        BOOST_CHECK_EQUAL( portFutures.get< InputData >( "NameOutputData" ).meaningOfLife,
+                           expected );
+    }
+}
+
+tuyau::Pipeline createPipeline( const uint32_t inputValue,
+                                size_t nConvertFilter = 1 )
+{
+    tuyau::Pipeline pipeline;
+    tuyau::PipeFilter pipeInput = pipeline.add< TestFilter >( "Producer" );
+    tuyau::PipeFilter pipeOutput = pipeline.add< TestFilter >( "Consumer" );
+
+    for( size_t i = 0; i < nConvertFilter; ++i )
+    {
+        std::stringstream name;
+        name << "Converter" << i;
+        tuyau::PipeFilter convertPipeFilter =
                 pipeline.add< ConvertFilter >( name.str( ));
         pipeInput.connect( "TestOutputData", convertPipeFilter, "ConvertInputData" );
         convertPipeFilter.connect( "ConvertOutputData", pipeOutput, "TestInputData" );
@@ -201,6 +714,33 @@ tuyau::Pipeline createPipeline( const uint32_t inputValue,
     return pipeline;
 }
 
+tuyau::Pipeline createChainPipeline( const uint32_t inputValue,
+                                     const size_t chainLength )
+{
+    tuyau::Pipeline pipeline;
+    tuyau::PipeFilter pipeInput = pipeline.add< TestFilter >( "Producer" );
+
+    tuyau::PipeFilter previous = pipeInput;
+    for( size_t i = 0; i < chainLength; ++i )
+    {
+        std::stringstream convertName;
+        convertName << "Converter" << i;
+        tuyau::PipeFilter convertPipeFilter =
+                pipeline.add< ConvertFilter >( convertName.str( ));
+
+        std::stringstream testName;
+        testName << "Tester" << i;
+        tuyau::PipeFilter testPipeFilter = pipeline.add< TestFilter >( testName.str( ));
+
+        previous.connect( "TestOutputData", convertPipeFilter, "ConvertInputData" );
+        convertPipeFilter.connect( "ConvertOutputData", testPipeFilter, "TestInputData" );
+        previous = testPipeFilter;
+    }
+
+    pipeInput.getPromise( "TestInputData" ).set( InputData( inputValue ));
+    return pipeline;
+}
+
 BOOST_AUTO_TEST_CASE( testSynchronousPipeline )
 {
     const uint32_t inputValue = 90;
@@ -291,6 +831,900 @@ BOOST_AUTO_TEST_CASE( testOneToManyManyToOnePipeline )
     }
 }
 
+BOOST_AUTO_TEST_CASE( testChainPipeline )
+{
+    const size_t chainLength = 200;
+    const uint32_t inputValue = 90;
+    tuyau::Pipeline pipeline = createChainPipeline( inputValue, chainLength );
+
+    tuyau::PushExecutor executor( 4 );
+    pipeline.schedule( executor );
+
+    std::stringstream name;
+    name << "Tester" << chainLength - 1;
+    const tuyau::Executable& pipeOutput = pipeline.getExecutable( name.str( ));
+    const tuyau::UniqueFutureMap portFutures( pipeOutput.getPostconditions( ));
+    const OutputData& outputData = portFutures.get< OutputData >( "TestOutputData" );
+    BOOST_CHECK_EQUAL( outputData.thanksForAllTheFish, 151 + 71 * chainLength );
+}
+
+/** Records the names of the scheduled executables */
+class RecordingExecutor : public tuyau::Executor
+{
+public:
+
+    explicit RecordingExecutor( tuyau::Executor& executor )
+        : _executor( executor )
+    {}
+
+    void schedule( tuyau::ExecutablePtr executable ) final
+    {
+        names.push_back( executable->getName( ));
+        _executor.schedule( executable );
+    }
+
+    std::vector< std::string > names;
+
+private:
+
+    tuyau::Executor& _executor;
+};
+
+BOOST_AUTO_TEST_CASE( testFusedChainPipeline )
+{
+    const uint32_t inputValue = 90;
+    const size_t chainLength = 10;
+    tuyau::Pipeline pipeline = createChainPipeline( inputValue, chainLength );
+    pipeline.setFusion( true );
+
+    // The chain is scheduled as a single executable
+    tuyau::PushExecutor pushExecutor( 2 );
+    RecordingExecutor executor( pushExecutor );
+    const tuyau::Futures futures = pipeline.schedule( executor );
+    for( const tuyau::Future& future: futures )
+        future.wait();
+    BOOST_REQUIRE_EQUAL( executor.names.size(), 1 );
+    BOOST_CHECK_EQUAL( executor.names.front().find( "Producer+Converter0+Tester0+" ), 0 );
+
+    // The outputs in the chain are published
+    for( size_t i = 0; i < chainLength; ++i )
+    {
+        std::stringstream name;
+        name << "Tester" << i;
+        const tuyau::UniqueFutureMap portFutures(
+                    pipeline.getExecutable( name.str( )).getPostconditions( ));
+        BOOST_CHECK_EQUAL( portFutures.get< OutputData >( "TestOutputData" ).thanksForAllTheFish,
+                           151 + 71 * ( i + 1 ));
+    }
+
+    // The chain is executed by a single task of the workers
+    tuyau::Workers workers( 2 );
+    tuyau::PipeFilter pipeInput =
+            static_cast< const tuyau::PipeFilter& >( pipeline.getExecutable( "Producer" ));
+    pipeline.reset();
+    pipeInput.getPromise( "TestInputData" ).set( InputData( inputValue ));
+    pipeline.execute( workers );
+
+    std::stringstream name;
+    name << "Tester" << chainLength - 1;
+    const tuyau::UniqueFutureMap portFutures(
+                pipeline.getExecutable( name.str( )).getPostconditions( ));
+    BOOST_CHECK_EQUAL( portFutures.get< OutputData >( "TestOutputData" ).thanksForAllTheFish,
+                       151 + 71 * chainLength );
+
+    // The fan-out and fan-in filters are not fused
+    tuyau::Pipeline fanPipeline = createPipeline( inputValue, 3 );
+    fanPipeline.setFusion( true );
+    executor.names.clear();
+    for( const tuyau::Future& future: fanPipeline.schedule( executor ))
+        future.wait();
+    BOOST_CHECK_EQUAL( executor.names.size(), 5 );
+
+    // A consumer with inputs from out of the pipeline is not fused, so its
+    // producer does not wait for them
+    tuyau::PipeFilterT< TestFilter > external( "External" );
+    tuyau::Pipeline externalPipeline;
+    tuyau::PipeFilter producer = externalPipeline.add< TestFilter >( "Producer" );
+    tuyau::PipeFilter consumer = externalPipeline.add< FutureNameFilter >( "Consumer" );
+    producer.connect( "TestOutputData", consumer, "NameInputData" );
+    external.connect( "TestOutputData", consumer, "NameInputData" );
+    externalPipeline.setFusion( true );
+    producer.getPromise( "TestInputData" ).set( InputData( 0 ));
+
+    executor.names.clear();
+    const tuyau::Futures externalFutures = externalPipeline.schedule( executor );
+    BOOST_CHECK_EQUAL( executor.names.size(), 2 );
+
+    const tuyau::UniqueFutureMap producerFutures( producer.getPostconditions( ));
+    BOOST_CHECK_EQUAL( producerFutures.get< OutputData >( "TestOutputData" ).thanksForAllTheFish,
+                       61 );
+
+    external.getPromise( "TestInputData" ).set( InputData( 10 ));
+    external.execute();
+    for( const tuyau::Future& future: externalFutures )
+        future.wait();
+
+    const tuyau::UniqueFutureMap consumerFutures( consumer.getPostconditions( ));
+    BOOST_CHECK_EQUAL( consumerFutures.get< InputData >( "NameOutputData" ).meaningOfLife,
+                       61 + 71 );
+}
+
+BOOST_AUTO_TEST_CASE( testWorkStealingPipeline )
+{
+    const uint32_t inputValue = 90;
+    tuyau::PushExecutor executor( 4, "Work Stealing", tuyau::WorkerSetupFunc(),
+                                  tuyau::Workers::WORK_STEALING );
+    {
+        tuyau::Pipeline pipeline = createPipeline( inputValue, 10 );
+        pipeline.schedule( executor );
+        const tuyau::Executable& pipeOutput = pipeline.getExecutable( "Consumer" );
+        const tuyau::UniqueFutureMap portFutures( pipeOutput.getPostconditions( ));
+        const OutputData& outputData = portFutures.get< OutputData >( "TestOutputData" );
+        BOOST_CHECK_EQUAL( outputData.thanksForAllTheFish, 1761 );
+    }
+    {
+        const size_t chainLength = 50;
+        tuyau::Pipeline pipeline = createChainPipeline( inputValue, chainLength );
+        pipeline.schedule( executor );
+
+        std::stringstream name;
+        name << "Tester" << chainLength - 1;
+        const tuyau::Executable& pipeOutput = pipeline.getExecutable( name.str( ));
+        const tuyau::UniqueFutureMap portFutures( pipeOutput.getPostconditions( ));
+        const OutputData& outputData = portFutures.get< OutputData >( "TestOutputData" );
+        BOOST_CHECK_EQUAL( outputData.thanksForAllTheFish, 151 + 71 * chainLength );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( testNumaPipeline )
+{
+    const std::vector< tuyau::Workers::Cores > nodes = tuyau::Workers::getNumaNodes();
+    BOOST_CHECK( !nodes.empty( ));
+    BOOST_CHECK( !nodes[ 0 ].empty( ));
+
+    const uint32_t inputValue = 90;
+    tuyau::PushExecutor executor( 4, "NUMA", tuyau::WorkerSetupFunc(),
+                                  tuyau::Workers::NUMA_NODES );
+    tuyau::Pipeline pipeline = createPipeline( inputValue, 10 );
+    pipeline.schedule( executor );
+    const tuyau::Executable& pipeOutput = pipeline.getExecutable( "Consumer" );
+    const tuyau::UniqueFutureMap portFutures( pipeOutput.getPostconditions( ));
+    const OutputData& outputData = portFutures.get< OutputData >( "TestOutputData" );
+    BOOST_CHECK_EQUAL( outputData.thanksForAllTheFish, 1761 );
+}
+
+BOOST_AUTO_TEST_CASE( testPinnedWorkers )
+{
+    const size_t core = tuyau::Workers::getNumaNodes()[ 0 ][ 0 ];
+    tuyau::Workers workers( 2, "Pinned Worker Pool", tuyau::WorkerSetupFunc(),
+                            tuyau::WorkerDestroyFunc(), tuyau::Workers::SHARED_QUEUE,
+                            tuyau::Workers::Cores( 1, core ));
+
+    std::promise< std::pair< int, std::string >> placement;
+    workers.submit( [ & ]
+    {
+        int cpu = -1;
+        char name[ 16 ] = { 0 };
+#ifdef __linux__
+        cpu = sched_getcpu();
+        pthread_getname_np( pthread_self(), name, sizeof( name ));
+#endif
+        placement.set_value( std::make_pair( cpu, std::string( name )));
+    });
+
+    const std::pair< int, std::string > result = placement.get_future().get();
+#ifdef __linux__
+    BOOST_CHECK_EQUAL( result.first, int( core ));
+    // The pool name is truncated to keep the thread index in 15 characters
+    BOOST_CHECK( result.second == "Pinned Worker 0" || result.second == "Pinned Worker 1" );
+#endif
+}
+
+BOOST_AUTO_TEST_CASE( testAsyncFilter )
+{
+    for( const tuyau::Workers::QueueMode queueMode: { tuyau::Workers::SHARED_QUEUE,
+                                                      tuyau::Workers::WORK_STEALING })
+    {
+        // The single worker would block on the gate, which is opened by the
+        // filter executed after the waiter
+        tuyau::PushExecutor executor( 1, "Async", tuyau::WorkerSetupFunc(), queueMode );
+        tuyau::Promise gate( tuyau::DataInfo( "Gate", tuyau::getType< uint32_t >( )));
+
+        tuyau::Pipeline pipeline;
+        tuyau::PipeFilter waiter = pipeline.add< AsyncGateFilter >( "Waiter", gate.getFuture( ));
+        tuyau::PipeFilter opener = pipeline.add< GateFilter >( "Opener", gate );
+        tuyau::Promise waiterInput = waiter.getPromise( "PureInputData" );
+        tuyau::Promise openerInput = opener.getPromise( "PureInputData" );
+
+        const tuyau::Futures futures = pipeline.schedule( executor );
+        waiterInput.set( 10u );
+        openerInput.set( 20u );
+
+        const tuyau::UniqueFutureMap portFutures( waiter.getPostconditions( ));
+        BOOST_CHECK_EQUAL( portFutures.get< uint32_t >( "PureOutputData" ), 31u );
+        for( const tuyau::Future& future: futures )
+            future.wait();
+    }
+
+    // Out of the workers, the waits block
+    tuyau::Promise gate( tuyau::DataInfo( "Gate", tuyau::getType< uint32_t >( )));
+    gate.set( 5u );
+    tuyau::PipeFilterT< AsyncGateFilter > waiter( "Waiter", gate.getFuture( ));
+    waiter.getPromise( "PureInputData" ).set( 10u );
+    waiter.execute();
+    const tuyau::UniqueFutureMap portFutures( waiter.getPostconditions( ));
+    BOOST_CHECK_EQUAL( portFutures.get< uint32_t >( "PureOutputData" ), 16u );
+}
+
+BOOST_AUTO_TEST_CASE( testSplitFilter )
+{
+    std::vector< uint32_t > values( 1000 );
+    std::iota( values.begin(), values.end(), 0 );
+
+    tuyau::Pipeline pipeline;
+    tuyau::PipeFilter sum = pipeline.add< SumFilter >( "Sum" );
+    sum.getPromise( "Values" ).set( values );
+
+    // The chunks follow the number of worker threads
+    tuyau::Workers workers( 4 );
+    pipeline.execute( workers );
+    BOOST_CHECK_EQUAL( SumFilter::chunks, 4 );
+
+    const tuyau::UniqueFutureMap portFutures( sum.getPostconditions( ));
+    BOOST_CHECK_EQUAL( portFutures.get< uint32_t >( "Sum" ), 499500u );
+
+    // Out of the workers, the filter is executed in a single chunk
+    SumFilter::chunks = 0;
+    pipeline.reset();
+    sum.getPromise( "Values" ).set( values );
+    pipeline.execute();
+    BOOST_CHECK_EQUAL( SumFilter::chunks, 1 );
+    BOOST_CHECK_EQUAL( tuyau::UniqueFutureMap( sum.getPostconditions( ))
+                           .get< uint32_t >( "Sum" ), 499500u );
+
+    // The single thread of the executor executes the chunks while the filter
+    // is suspended
+    SumFilter::chunks = 0;
+    tuyau::PushExecutor executor( 1 );
+    tuyau::PipeFilterT< SumFilter > fixedSum( "FixedSum", size_t( 8 ));
+    fixedSum.getPromise( "Values" ).set( values );
+    for( const tuyau::Future& future: fixedSum.schedule( executor ))
+        future.wait();
+    BOOST_CHECK_EQUAL( SumFilter::chunks, 8 );
+    BOOST_CHECK_EQUAL( tuyau::UniqueFutureMap( fixedSum.getPostconditions( ))
+                           .get< uint32_t >( "Sum" ), 499500u );
+}
+
+BOOST_AUTO_TEST_CASE( testParallelPipeline )
+{
+    const uint32_t inputValue = 90;
+    tuyau::Workers workers( 4 );
+    {
+        tuyau::Pipeline pipeline = createPipeline( inputValue, 10 );
+        const tuyau::Executable& pipeOutput = pipeline.getExecutable( "Consumer" );
+        tuyau::PipeFilter pipeInput =
+                static_cast< const tuyau::PipeFilter& >(
+                    pipeline.getExecutable( "Producer" ));
+
+        // The cached order is valid after reset
+        for( size_t i = 0; i < 2; ++i )
+        {
+            pipeline.reset();
+            pipeInput.getPromise( "TestInputData" ).set( InputData( inputValue ));
+            pipeline.execute( workers );
+
+            const tuyau::UniqueFutureMap portFutures( pipeOutput.getPostconditions( ));
+            const OutputData& outputData = portFutures.get< OutputData >( "TestOutputData" );
+            BOOST_CHECK_EQUAL( outputData.thanksForAllTheFish, 1761 );
+        }
+    }
+    {
+        const size_t chainLength = 200;
+        tuyau::Pipeline pipeline = createChainPipeline( inputValue, chainLength );
+        pipeline.execute( workers );
+
+        std::stringstream name;
+        name << "Tester" << chainLength - 1;
+        const tuyau::Executable& pipeOutput = pipeline.getExecutable( name.str( ));
+        const tuyau::UniqueFutureMap portFutures( pipeOutput.getPostconditions( ));
+        const OutputData& outputData = portFutures.get< OutputData >( "TestOutputData" );
+        BOOST_CHECK_EQUAL( outputData.thanksForAllTheFish, 151 + 71 * chainLength );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( testPipelineOrderInvalidation )
+{
+    const uint32_t inputValue = 90;
+    tuyau::Pipeline pipeline = createPipeline( inputValue, 1 );
+    pipeline.execute();
+
+    const tuyau::Executable& pipeOutput = pipeline.getExecutable( "Consumer" );
+    const tuyau::UniqueFutureMap portFutures1( pipeOutput.getPostconditions( ));
+    BOOST_CHECK_EQUAL( portFutures1.get< OutputData >( "TestOutputData" ).thanksForAllTheFish,
+                       222 );
+
+    // A new executable and its connections invalidate the cached order
+    tuyau::PipeFilter pipeInput =
+            static_cast< const tuyau::PipeFilter& >( pipeline.getExecutable( "Producer" ));
+    tuyau::PipeFilter pipeConsumer =
+            static_cast< const tuyau::PipeFilter& >( pipeline.getExecutable( "Consumer" ));
+    tuyau::PipeFilter convertPipeFilter = pipeline.add< ConvertFilter >( "Converter1" );
+    pipeInput.connect( "TestOutputData", convertPipeFilter, "ConvertInputData" );
+    convertPipeFilter.connect( "ConvertOutputData", pipeConsumer, "TestInputData" );
+
+    pipeline.reset();
+    pipeInput.getPromise( "TestInputData" ).set( InputData( inputValue ));
+    pipeline.execute();
+
+    const tuyau::UniqueFutureMap portFutures2( pipeOutput.getPostconditions( ));
+    BOOST_CHECK_EQUAL( portFutures2.get< OutputData >( "TestOutputData" ).thanksForAllTheFish,
+                       393 );
+
+    // The pipeline postconditions follow the resets
+    const tuyau::FutureMap pipelineFutures( pipeline.getPostconditions( ));
+    BOOST_CHECK( pipelineFutures.isReady( ));
+}
+
+BOOST_AUTO_TEST_CASE( testPipelineStream )
+{
+    const size_t chainLength = 5;
+    const size_t frameCount = 20;
+    tuyau::Pipeline pipeline = createChainPipeline( 0, chainLength );
+
+    std::stringstream name;
+    name << "Tester" << chainLength - 1;
+
+    tuyau::PushExecutor executor( 4 );
+    tuyau::PipelineStream stream( pipeline, executor, 3 );
+    BOOST_CHECK_EQUAL( stream.getMaxFramesInFlight(), 3 );
+
+    tuyau::Futures results;
+    for( uint32_t frame = 0; frame < frameCount; ++frame )
+    {
+        tuyau::Pipeline& framePipeline = stream.push();
+        const tuyau::Futures& futures =
+                framePipeline.getExecutable( name.str( )).getPostconditions();
+        results.push_back( futures.front( ));
+
+        tuyau::PipeFilter pipeInput =
+                static_cast< const tuyau::PipeFilter& >(
+                    framePipeline.getExecutable( "Producer" ));
+        pipeInput.getPromise( "TestInputData" ).set( InputData( frame ));
+    }
+    stream.wait();
+
+    uint32_t frame = 0;
+    for( const auto& future: results )
+    {
+        BOOST_CHECK_EQUAL( future.get< OutputData >().thanksForAllTheFish,
+                           frame++ + 61 + 71 * chainLength );
+    }
+
+    // The original pipeline is not executed by the stream
+    const tuyau::FutureMap pipelineFutures( pipeline.getPostconditions( ));
+    BOOST_CHECK( !pipelineFutures.isReady( ));
+
+    tuyau::Pipeline outer;
+    outer.add( "Inner", pipeline );
+    BOOST_CHECK_THROW( outer.replicate(), std::logic_error );
+}
+
+BOOST_AUTO_TEST_CASE( testPipelineStreamCancel )
+{
+    const tuyau::Pipeline pipeline = createChainPipeline( 0, 2 );
+    tuyau::PushExecutor executor( 2 );
+    {
+        tuyau::PipelineStream stream( pipeline, executor, 1 );
+
+        // The input of the frame is never set
+        const tuyau::Futures results =
+                stream.push().getExecutable( "Tester1" ).getPostconditions();
+
+        // A push() waiting for the slot is released by cancel()
+        std::thread pushThread( [ & ]{ stream.push(); });
+        stream.cancel();
+        pushThread.join();
+        BOOST_CHECK_THROW( results.front().get< OutputData >(), std::runtime_error );
+
+        // The destruction cancels the frame started by the thread
+    }
+    {
+        // The executables dropped by the executor finish the frame, once
+        // their inputs are flushed
+        tuyau::PipelineStream stream( pipeline, executor, 1 );
+        const tuyau::Futures results =
+                stream.push().getExecutable( "Tester1" ).getPostconditions();
+        executor.clear();
+        stream.cancel();
+        BOOST_CHECK_THROW( results.front().get< OutputData >(), std::runtime_error );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( testOutputCache )
+{
+    tuyau::PipeFilterT< TestFilter > impureFilter( "Impure" );
+    BOOST_CHECK_THROW( impureFilter.setCacheSize( 1 ), std::logic_error );
+
+    tuyau::PipeFilterT< PureFilter > pipeFilter( "Pure" );
+    pipeFilter.setCacheSize( 2 );
+    PureFilter::executions = 0;
+
+    const auto run = [ & ]( const uint32_t value )
+    {
+        pipeFilter.reset();
+        pipeFilter.getPromise( "PureInputData" ).set( value );
+        pipeFilter.execute();
+
+        const tuyau::UniqueFutureMap portFutures( pipeFilter.getPostconditions( ));
+        return portFutures.get< uint32_t >( "PureOutputData" );
+    };
+
+    BOOST_CHECK_EQUAL( run( 1 ), 2 );
+    BOOST_CHECK_EQUAL( run( 1 ), 2 );
+    BOOST_CHECK_EQUAL( PureFilter::executions, 1 );
+
+    BOOST_CHECK_EQUAL( run( 2 ), 4 );
+    BOOST_CHECK_EQUAL( run( 3 ), 6 ); // Evicts the outputs for 1
+    BOOST_CHECK_EQUAL( run( 1 ), 2 );
+    BOOST_CHECK_EQUAL( run( 3 ), 6 );
+    BOOST_CHECK_EQUAL( PureFilter::executions, 4 );
+
+    const tuyau::CacheStats stats = pipeFilter.getCacheStats();
+    BOOST_CHECK_EQUAL( stats.hits, 2 );
+    BOOST_CHECK_EQUAL( stats.misses, 4 );
+    BOOST_CHECK_EQUAL( stats.bypasses, 0 );
+    BOOST_CHECK_EQUAL( stats.size, 2 );
+
+    pipeFilter.setCacheSize( 0 );
+    BOOST_CHECK_EQUAL( run( 3 ), 6 );
+    BOOST_CHECK_EQUAL( PureFilter::executions, 5 );
+    BOOST_CHECK_EQUAL( pipeFilter.getCacheStats().hits, 0 );
+
+    BOOST_CHECK( !tuyau::DataHash< InputData >::enabled );
+    BOOST_CHECK( tuyau::DataHash< std::vector< uint32_t >>::enabled );
+    BOOST_CHECK( tuyau::DataHash< std::string >::enabled );
+}
+
+BOOST_AUTO_TEST_CASE( testOutputCacheCollision )
+{
+    // All the inputs have the same hash, the cache compares the inputs
+    tuyau::PipeFilterT< CollidingFilter > pipeFilter( "Colliding" );
+    pipeFilter.setCacheSize( 2 );
+
+    const auto run = [ & ]( const uint32_t value )
+    {
+        pipeFilter.reset();
+        pipeFilter.getPromise( "CollidingInputData" ).set( CollidingData{ value });
+        pipeFilter.execute();
+
+        const tuyau::UniqueFutureMap portFutures( pipeFilter.getPostconditions( ));
+        return portFutures.get< uint32_t >( "CollidingOutputData" );
+    };
+
+    BOOST_CHECK_EQUAL( run( 1 ), 2 );
+    BOOST_CHECK_EQUAL( run( 2 ), 4 );
+    BOOST_CHECK_EQUAL( run( 2 ), 4 );
+    BOOST_CHECK_EQUAL( run( 1 ), 2 );
+
+    const tuyau::CacheStats stats = pipeFilter.getCacheStats();
+    BOOST_CHECK_EQUAL( stats.hits, 1 );
+    BOOST_CHECK_EQUAL( stats.misses, 3 );
+    BOOST_CHECK_EQUAL( stats.size, 1 );
+}
+
+BOOST_AUTO_TEST_CASE( testIncrementalExecution )
+{
+    tuyau::Workers workers( 2 );
+    for( const bool parallel: { false, true })
+    {
+        tuyau::Pipeline pipeline;
+        tuyau::PipeFilter source = pipeline.add< PureFilter >( "Source" );
+        tuyau::PipeFilter consumer = pipeline.add< PureFilter >( "Consumer" );
+        tuyau::PipeFilter other = pipeline.add< PureFilter >( "Other" );
+        source.connect( "PureOutputData", consumer, "PureInputData" );
+
+        const auto execute = [ & ]
+        {
+            if( parallel )
+                pipeline.execute( workers );
+            else
+                pipeline.execute();
+        };
+
+        PureFilter::executions = 0;
+        tuyau::Promise sourceInput = source.getPromise( "PureInputData" );
+        sourceInput.set( 1u );
+        other.getPromise( "PureInputData" ).set( 1u );
+        execute();
+        BOOST_CHECK_EQUAL( PureFilter::executions, 3 );
+
+        // Nothing changed
+        execute();
+        BOOST_CHECK_EQUAL( PureFilter::executions, 3 );
+
+        // Only the source and its consumer are executed with the new input
+        const tuyau::Futures otherOutputs = other.getPostconditions();
+        sourceInput.reset();
+        sourceInput.set( 2u );
+        execute();
+        BOOST_CHECK_EQUAL( PureFilter::executions, 5 );
+        BOOST_CHECK( other.getPostconditions() == otherOutputs );
+
+        const tuyau::UniqueFutureMap portFutures( consumer.getPostconditions( ));
+        BOOST_CHECK_EQUAL( portFutures.get< uint32_t >( "PureOutputData" ), 8 );
+
+        // Reset discards the history
+        pipeline.reset();
+        sourceInput.set( 3u );
+        other.getPromise( "PureInputData" ).set( 1u );
+        execute();
+        BOOST_CHECK_EQUAL( PureFilter::executions, 8 );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( testIncrementalExecutionNestedPipeline )
+{
+    tuyau::Workers workers( 2 );
+    tuyau::PushExecutor executor( 2 );
+    for( size_t mode = 0; mode < 3; ++mode )
+    {
+        tuyau::Pipeline inner;
+        tuyau::PipeFilter middle = inner.add< PureFilter >( "Middle" );
+
+        tuyau::Pipeline pipeline;
+        tuyau::PipeFilter source = pipeline.add< PureFilter >( "Source" );
+        pipeline.add( "Inner", inner );
+        tuyau::PipeFilter consumer = pipeline.add< PureFilter >( "Consumer" );
+        source.connect( "PureOutputData", middle, "PureInputData" );
+        middle.connect( "PureOutputData", consumer, "PureInputData" );
+
+        const auto execute = [ & ]
+        {
+            if( mode == 0 )
+                pipeline.execute();
+            else if( mode == 1 )
+                pipeline.execute( workers );
+            else
+                tuyau::FutureMap( pipeline.schedule( executor )).wait();
+        };
+
+        PureFilter::executions = 0;
+        tuyau::Promise sourceInput = source.getPromise( "PureInputData" );
+        sourceInput.set( 1u );
+        execute();
+        BOOST_CHECK_EQUAL( PureFilter::executions, 3 );
+        BOOST_CHECK_EQUAL( consumer.getPostconditions().front().get< uint32_t >(), 8 );
+
+        // Nothing changed
+        execute();
+        BOOST_CHECK_EQUAL( PureFilter::executions, 3 );
+
+        // The new input changes the nested pipeline and its consumer
+        sourceInput.reset();
+        sourceInput.set( 2u );
+        execute();
+        BOOST_CHECK_EQUAL( PureFilter::executions, 6 );
+        BOOST_CHECK_EQUAL( consumer.getPostconditions().front().get< uint32_t >(), 16 );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( testIncrementalExecutionAfterClear )
+{
+    tuyau::PushExecutor executor( 2 );
+    tuyau::Pipeline pipeline;
+    tuyau::PipeFilter source = pipeline.add< PureFilter >( "Source" );
+    tuyau::PipeFilter consumer = pipeline.add< PureFilter >( "Consumer" );
+    source.connect( "PureOutputData", consumer, "PureInputData" );
+
+    // The executables dropped by clear() are not recorded as executed, so
+    // the next schedule executes them
+    PureFilter::executions = 0;
+    tuyau::Promise sourceInput = source.getPromise( "PureInputData" );
+    pipeline.schedule( executor );
+    executor.clear();
+
+    sourceInput.set( 1u );
+    pipeline.schedule( executor );
+
+    const tuyau::UniqueFutureMap portFutures( consumer.getPostconditions( ));
+    BOOST_CHECK_EQUAL( portFutures.get< uint32_t >( "PureOutputData" ), 4 );
+    BOOST_CHECK_EQUAL( PureFilter::executions, 2 );
+
+    // The completed executions are recorded
+    pipeline.schedule( executor );
+    BOOST_CHECK_EQUAL( portFutures.get< uint32_t >( "PureOutputData" ), 4 );
+    BOOST_CHECK_EQUAL( PureFilter::executions, 2 );
+}
+
+BOOST_AUTO_TEST_CASE( testOutputRelease )
+{
+    tuyau::Workers workers( 2 );
+    tuyau::PushExecutor executor( 2 );
+    for( size_t mode = 0; mode < 3; ++mode )
+    {
+        tuyau::Pipeline pipeline;
+        tuyau::PipeFilter source = pipeline.add< PureFilter, false >( "Source" );
+        tuyau::PipeFilter unused = pipeline.add< PureFilter, false >( "Unused" );
+        tuyau::PipeFilter consumer1 = pipeline.add< PureFilter, false >( "Consumer1" );
+        tuyau::PipeFilter consumer2 = pipeline.add< PureFilter >( "Consumer2" );
+        source.connect( "PureOutputData", consumer1, "PureInputData" );
+        source.connect( "PureOutputData", consumer2, "PureInputData" );
+        consumer1.connect( "PureOutputData", consumer2, "PureInputData" );
+        source.getPromise( "PureInputData" ).set( 1u );
+        unused.getPromise( "PureInputData" ).set( 1u );
+
+        const auto execute = [ & ]
+        {
+            if( mode == 0 )
+                pipeline.execute();
+            else if( mode == 1 )
+                pipeline.execute( workers );
+            else
+            {
+                const tuyau::FutureMap futures( pipeline.schedule( executor ));
+                futures.wait();
+
+                // The outputs are released after the consumers publish theirs
+                const tuyau::Future released = consumer1.getPostconditions().front();
+                for( size_t i = 0; i < 1000 && !released.isReleased(); ++i )
+                    std::this_thread::sleep_for( std::chrono::milliseconds( 1 ));
+            }
+        };
+
+        PureFilter::executions = 0;
+        execute();
+        BOOST_CHECK_EQUAL( PureFilter::executions, 4 );
+
+        // The outputs are released after their last consumer
+        const tuyau::Future sourceOutput = source.getPostconditions().front();
+        BOOST_CHECK( sourceOutput.isReady( ));
+        BOOST_CHECK( sourceOutput.isReleased( ));
+        BOOST_CHECK_THROW( sourceOutput.get< uint32_t >(), std::runtime_error );
+        BOOST_CHECK( consumer1.getPostconditions().front().isReleased( ));
+
+        // The outputs without consumers and the waited outputs are kept
+        const tuyau::Future unusedOutput = unused.getPostconditions().front();
+        const tuyau::Future output = consumer2.getPostconditions().front();
+        BOOST_CHECK( !unusedOutput.isReleased( ));
+        BOOST_CHECK_EQUAL( unusedOutput.get< uint32_t >(), 2 );
+        BOOST_CHECK( !output.isReleased( ));
+        BOOST_CHECK_EQUAL( output.get< uint32_t >(), 12 );
+
+        // The released outputs are not computed again, unless a consumer
+        // needs them
+        execute();
+        BOOST_CHECK_EQUAL( PureFilter::executions, 4 );
+        BOOST_CHECK_EQUAL( consumer2.getPostconditions().front().get< uint32_t >(), 12 );
+
+        tuyau::Promise sourceInput = source.getPromise( "PureInputData" );
+        sourceInput.reset();
+        sourceInput.set( 2u );
+        execute();
+        BOOST_CHECK_EQUAL( PureFilter::executions, 7 );
+        BOOST_CHECK_EQUAL( consumer2.getPostconditions().front().get< uint32_t >(), 24 );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( testIncrementalExecutionWithRelease )
+{
+    tuyau::Workers workers( 2 );
+    for( const bool parallel: { false, true })
+    {
+        // Two branches, where only the ends are waited on and the first one
+        // has another source
+        tuyau::Pipeline pipeline;
+        tuyau::PipeFilter source1 = pipeline.add< PureFilter, false >( "Source1" );
+        tuyau::PipeFilter source2 = pipeline.add< PureFilter, false >( "Source2" );
+        tuyau::PipeFilter source3 = pipeline.add< PureFilter, false >( "Source3" );
+        tuyau::PipeFilter middle1 = pipeline.add< PureFilter, false >( "Middle1" );
+        tuyau::PipeFilter middle2 = pipeline.add< PureFilter, false >( "Middle2" );
+        tuyau::PipeFilter end1 = pipeline.add< PureFilter >( "End1" );
+        tuyau::PipeFilter end2 = pipeline.add< PureFilter >( "End2" );
+        source1.connect( "PureOutputData", middle1, "PureInputData" );
+        middle1.connect( "PureOutputData", end1, "PureInputData" );
+        source3.connect( "PureOutputData", end1, "PureInputData" );
+        source2.connect( "PureOutputData", middle2, "PureInputData" );
+        middle2.connect( "PureOutputData", end2, "PureInputData" );
+
+        tuyau::Promise input1 = source1.getPromise( "PureInputData" );
+        tuyau::Promise input2 = source2.getPromise( "PureInputData" );
+        tuyau::Promise input3 = source3.getPromise( "PureInputData" );
+        input1.set( 1u );
+        input2.set( 1u );
+        input3.set( 1u );
+
+        const auto execute = [ & ]
+        {
+            if( parallel )
+                pipeline.execute( workers );
+            else
+                pipeline.execute();
+        };
+
+        PureFilter::executions = 0;
+        execute();
+        BOOST_CHECK_EQUAL( PureFilter::executions, 7 );
+        BOOST_CHECK( middle2.getPostconditions().front().isReleased( ));
+
+        execute();
+        BOOST_CHECK_EQUAL( PureFilter::executions, 7 );
+
+        // The released intermediates of the untouched branch are not executed
+        const tuyau::Future output1 = end1.getPostconditions().front();
+        input2.reset();
+        input2.set( 2u );
+        execute();
+        BOOST_CHECK_EQUAL( PureFilter::executions, 10 );
+        BOOST_CHECK( end1.getPostconditions().front() == output1 );
+        BOOST_CHECK_EQUAL( output1.get< uint32_t >(), 12 );
+        BOOST_CHECK_EQUAL( end2.getPostconditions().front().get< uint32_t >(), 16 );
+
+        // The released intermediates needed by a changed consumer are
+        // executed again
+        const tuyau::Future output2 = end2.getPostconditions().front();
+        input3.reset();
+        input3.set( 2u );
+        execute();
+        BOOST_CHECK_EQUAL( PureFilter::executions, 14 );
+        BOOST_CHECK( end2.getPostconditions().front() == output2 );
+        BOOST_CHECK_EQUAL( end1.getPostconditions().front().get< uint32_t >(), 16 );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( testMemoryBudget )
+{
+    const size_t branchCount = 8;
+    tuyau::PushExecutor executor( 4 );
+    executor.setMemoryBudget( 250 );
+    BOOST_CHECK_EQUAL( executor.getMemoryBudget(), 250 );
+
+    tuyau::Pipeline pipeline;
+    tuyau::PipeFilter source = pipeline.add< PureFilter >( "Source" );
+    tuyau::PipeFilter sink = pipeline.add< PureFilter >( "Sink" );
+    for( size_t i = 0; i < branchCount; ++i )
+    {
+        tuyau::PipeFilter branch =
+                pipeline.add< LargeOutputFilter >( "Branch" + std::to_string( i ));
+        source.connect( "PureOutputData", branch, "PureInputData" );
+        branch.connect( "PureOutputData", sink, "PureInputData" );
+    }
+
+    // The outputs of the branches are needed until the sink is finished, so
+    // at most two branches fit into the budget at once
+    LargeOutputFilter::maxRunning = 0;
+    tuyau::Promise input = source.getPromise( "PureInputData" );
+    pipeline.schedule( executor );
+    input.set( 1u );
+
+    const tuyau::UniqueFutureMap portFutures( sink.getPostconditions( ));
+    BOOST_CHECK_EQUAL( portFutures.get< uint32_t >( "PureOutputData" ), 8 * branchCount );
+    BOOST_CHECK_LE( LargeOutputFilter::maxRunning, 2 );
+
+    // The sink returns the memory of the branches after its execution
+    for( size_t i = 0; i < 1000 && executor.getReservedMemory() > 0; ++i )
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ));
+    BOOST_CHECK_EQUAL( executor.getReservedMemory(), 0 );
+}
+
+BOOST_AUTO_TEST_CASE( testSchedulingPolicies )
+{
+    // The consumers of the source become ready while the single worker
+    // executes the source, so they are ordered by the policy
+    const auto run = [ & ]( const tuyau::SchedulingPolicyPtr& policy,
+                            const std::function< void( tuyau::Pipeline& ) >& setup )
+    {
+        tuyau::PushExecutor executor( 1 );
+        executor.setSchedulingPolicy( policy );
+
+        tuyau::Pipeline pipeline;
+        tuyau::PipeFilter source = pipeline.add< OrderFilter >( "Source", "Source" );
+        tuyau::PipeFilter chain = source;
+        for( const char* name: { "Z0", "Z1", "Z2" })
+        {
+            tuyau::PipeFilter next = pipeline.add< OrderFilter >( name, name );
+            chain.connect( "PureOutputData", next, "PureInputData" );
+            chain = next;
+        }
+
+        for( const char* name: { "A0", "A1" })
+        {
+            tuyau::PipeFilter single = pipeline.add< OrderFilter >( name, name );
+            source.connect( "PureOutputData", single, "PureInputData" );
+        }
+        setup( pipeline );
+
+        OrderFilter::order.clear();
+        tuyau::Promise input = source.getPromise( "PureInputData" );
+        const tuyau::FutureMap futures( pipeline.schedule( executor ));
+        input.set( 0u );
+        futures.wait();
+        return OrderFilter::order;
+    };
+
+    const auto noSetup = []( tuyau::Pipeline& ) {};
+    const std::vector< std::string > fifo =
+            run( std::make_shared< tuyau::FifoPolicy >(), noSetup );
+    const std::vector< std::string > expectedFifo = { "Source", "A0", "A1", "Z0", "Z1", "Z2" };
+    BOOST_CHECK_EQUAL_COLLECTIONS( fifo.begin(), fifo.end(),
+                                   expectedFifo.begin(), expectedFifo.end( ));
+
+    const std::vector< std::string > priority =
+            run( std::make_shared< tuyau::PriorityPolicy >(), []( tuyau::Pipeline& pipeline )
+    {
+        static_cast< tuyau::PipeFilter& >( pipeline.getExecutable( "A0" )).setPriority( 1 );
+        static_cast< tuyau::PipeFilter& >( pipeline.getExecutable( "A1" )).setPriority( 2 );
+    });
+    const std::vector< std::string > expectedPriority = { "Source", "A1", "A0", "Z0", "Z1", "Z2" };
+    BOOST_CHECK_EQUAL_COLLECTIONS( priority.begin(), priority.end(),
+                                   expectedPriority.begin(), expectedPriority.end( ));
+
+    // The chain is the longest downstream path
+    const auto criticalPath = std::make_shared< tuyau::CriticalPathPolicy >();
+    const std::vector< std::string > critical = run( criticalPath, noSetup );
+    BOOST_CHECK_EQUAL( critical.size(), 6 );
+    BOOST_CHECK_EQUAL( critical[ 1 ], "Z0" );
+    BOOST_CHECK_GT( criticalPath->getRuntime( "Z0" ), 0 );
+    BOOST_CHECK_EQUAL( criticalPath->getRuntime( "Unknown" ), 0 );
+}
+
+BOOST_AUTO_TEST_CASE( testCriticalPathRanks )
+{
+    tuyau::PipeFilterT< PureFilter > source( "Source" );
+    tuyau::PipeFilterT< PureFilter > consumer( "Consumer" );
+    tuyau::PipeFilterT< PureFilter > other( "Other" );
+    source.connect( "PureOutputData", consumer, "PureInputData" );
+    source.getPromise( "PureInputData" );
+
+    // The executables without history count with the average runtime
+    tuyau::CriticalPathPolicy policy;
+    policy.onScheduled( source );
+    policy.onScheduled( consumer );
+    BOOST_CHECK_EQUAL( policy.getRank( source ), 2 );
+
+    // The ranks follow the updated runtimes
+    policy.onExecuted( other, 100 );
+    BOOST_CHECK_EQUAL( policy.getRank( source ), 200 );
+
+    // The cleared executables are not ranked with their consumers
+    policy.onCleared();
+    BOOST_CHECK_EQUAL( policy.getRank( source ), 100 );
+}
+
+BOOST_AUTO_TEST_CASE( testCriticalPathRankUpdates )
+{
+    tuyau::PipeFilterT< PureFilter > source( "Source" );
+    tuyau::PipeFilterT< PureFilter > consumer( "Consumer" );
+    tuyau::PipeFilterT< PureFilter > consumerRun( "Consumer" );
+    source.connect( "PureOutputData", consumer, "PureInputData" );
+    source.getPromise( "PureInputData" );
+
+    // The other executables keep the average runtime stable
+    tuyau::CriticalPathPolicy policy;
+    std::vector< std::unique_ptr< tuyau::PipeFilterT< PureFilter >>> others;
+    for( size_t i = 0; i < 100; ++i )
+    {
+        others.emplace_back( new tuyau::PipeFilterT< PureFilter >( "Other" +
+                                                                   std::to_string( i )));
+        policy.onExecuted( *others.back(), 100 );
+    }
+    policy.onExecuted( consumerRun, 100 );
+
+    policy.onScheduled( source );
+    policy.onScheduled( consumer );
+    BOOST_CHECK_EQUAL( policy.getRank( source ), 200 );
+
+    // The small moves of the runtimes keep the ranks
+    policy.onExecuted( consumerRun, 104 );
+    BOOST_CHECK_EQUAL( policy.getRuntime( "Consumer" ), 101 );
+    BOOST_CHECK_EQUAL( policy.getRank( source ), 200 );
+
+    // The larger ones update the ranks upstream
+    policy.onExecuted( consumerRun, 1000 );
+    BOOST_CHECK_EQUAL( policy.getRuntime( "Consumer" ), 325.75 );
+    BOOST_CHECK_EQUAL( policy.getRank( consumer ), 325.75 );
+    BOOST_CHECK_EQUAL( policy.getRank( source ), 425.75 );
+}
+
 BOOST_AUTO_TEST_CASE( testPromiseFuture )
 {
     tuyau::Promise promise( tuyau::DataInfo( "Helloworld", tuyau::getType< uint32_t >( )));
@@ -312,12 +1746,159 @@ BOOST_AUTO_TEST_CASE( testPromiseFuture )
     tuyau::Future future3 = promise.getFuture();
     BOOST_CHECK( future1 != future3 );
 
+    // The identifiers are ordered by the creation of the promise values
+    BOOST_CHECK_EQUAL( future1.getId(), future2.getId( ));
+    BOOST_CHECK( future1 < future3 );
+    const std::unordered_set< tuyau::Future > futureSet = { future1, future2, future3 };
+    BOOST_CHECK_EQUAL( futureSet.size(), 2 );
+
     // Promise is set with explicit conversion
     promise.set< uint32_t >( 43.0f );
     BOOST_CHECK_EQUAL( future1.get< uint32_t >(), 42u );
     BOOST_CHECK_EQUAL( future3.get< uint32_t >(), 43u );
 }
 
+struct CopyCounter
+{
+    explicit CopyCounter( const uint32_t value_ = 0 )
+        : value( value_ )
+    {}
+
+    CopyCounter( const CopyCounter& other )
+        : value( other.value )
+    {
+        ++copies;
+    }
+
+    CopyCounter( CopyCounter&& other )
+        : value( other.value )
+    {
+        ++moves;
+    }
+
+    uint32_t value;
+    static size_t copies;
+    static size_t moves;
+};
+
+size_t CopyCounter::copies = 0;
+size_t CopyCounter::moves = 0;
+
+BOOST_AUTO_TEST_CASE( testPromiseSetWithoutCopy )
+{
+    const tuyau::DataInfo dataInfo( "Counter", tuyau::getType< CopyCounter >( ));
+
+    tuyau::Promise promise( dataInfo );
+    const tuyau::Future future( promise );
+    promise.set( CopyCounter( 1 ));
+    BOOST_CHECK_EQUAL( future.get< CopyCounter >().value, 1 );
+    BOOST_CHECK_EQUAL( CopyCounter::copies, 0 );
+    BOOST_CHECK_EQUAL( CopyCounter::moves, 1 );
+
+    promise.reset();
+    promise.emplace< CopyCounter >( 2u );
+    BOOST_CHECK_EQUAL( future.get< CopyCounter >().value, 2 );
+    BOOST_CHECK_EQUAL( CopyCounter::copies, 0 );
+    BOOST_CHECK_EQUAL( CopyCounter::moves, 1 );
+
+    promise.reset();
+    const std::shared_ptr< const CopyCounter > shared =
+            std::make_shared< CopyCounter >( 3 );
+    promise.adopt( shared );
+    BOOST_CHECK_EQUAL( &future.get< CopyCounter >(), shared.get( ));
+    BOOST_CHECK_EQUAL( CopyCounter::copies, 0 );
+
+    promise.reset();
+    BOOST_CHECK_THROW( promise.adopt( std::shared_ptr< CopyCounter >( )),
+                       std::runtime_error );
+
+    tuyau::PromiseMap promiseMap( { promise } );
+    promiseMap.emplace< CopyCounter >( "Counter", 4u );
+    BOOST_CHECK_EQUAL( future.get< CopyCounter >().value, 4 );
+    BOOST_CHECK_EQUAL( CopyCounter::copies, 0 );
+    BOOST_CHECK_EQUAL( CopyCounter::moves, 1 );
+}
+
+BOOST_AUTO_TEST_CASE( testFutureReadyCallback )
+{
+    tuyau::Promise promise( tuyau::DataInfo( "Helloworld", tuyau::getType< uint32_t >( )));
+    const tuyau::Future future = promise.getFuture();
+
+    size_t calls = 0;
+    future.onReady( [ & ]{ ++calls; });
+    BOOST_CHECK_EQUAL( calls, 0 );
+
+    promise.set( 42u );
+    BOOST_CHECK_EQUAL( calls, 1 );
+
+    // Already ready futures call the callback immediately
+    future.onReady( [ & ]{ ++calls; });
+    BOOST_CHECK_EQUAL( calls, 2 );
+
+    // Callbacks are registered on the current value of the promise
+    promise.reset();
+    const tuyau::Future resetFuture( promise );
+    resetFuture.onReady( [ & ]{ ++calls; });
+    promise.reset();
+    BOOST_CHECK_EQUAL( calls, 3 );
+}
+
+BOOST_AUTO_TEST_CASE( testPromiseSetCallback )
+{
+    tuyau::Promise promise( tuyau::DataInfo( "Helloworld", tuyau::getType< uint32_t >( )));
+
+    std::vector< uint32_t > values;
+    size_t flushes = 0;
+    promise.onSet( [ & ]( const tuyau::Future& future )
+    {
+        BOOST_CHECK( future.isReady( ));
+        if( future.getPortData( ))
+            values.push_back( future.get< uint32_t >( ));
+        else
+            ++flushes;
+    });
+
+    promise.set( 42u );
+    BOOST_CHECK_EQUAL( values.size(), 1 );
+
+    // The callback stays registered after the reset, which flushes the
+    // promise if it is not set
+    promise.reset();
+    promise.set( 43u );
+    promise.reset();
+    promise.reset();
+    BOOST_CHECK_EQUAL( values.size(), 2 );
+    BOOST_CHECK_EQUAL( values.back(), 43u );
+    BOOST_CHECK_EQUAL( flushes, 1 );
+}
+
+BOOST_AUTO_TEST_CASE( testFutureContinuation )
+{
+    tuyau::PushExecutor executor( 2 );
+    tuyau::Promise promise( tuyau::DataInfo( "Helloworld", tuyau::getType< uint32_t >( )));
+
+    std::atomic< uint32_t > result( 0 );
+    std::atomic< bool > chained( false );
+    const tuyau::Future done = promise.getFuture().then( [ & ]( const tuyau::Future& future )
+    {
+        result = future.get< uint32_t >() * 2;
+    }, executor );
+
+    const tuyau::Future chainDone = done.then( [ & ]( const tuyau::Future& future )
+    {
+        // The chained continuation runs after the first one
+        chained = result == 84u && future.isReady();
+    }, executor );
+
+    BOOST_CHECK( !done.isReady( ));
+    promise.set( 42u );
+
+    chainDone.wait();
+    BOOST_CHECK( done.isReady( ));
+    BOOST_CHECK_EQUAL( result, 84u );
+    BOOST_CHECK( chained );
+}
+
 BOOST_AUTO_TEST_CASE( testFutureMaps )
 {
     tuyau::PipeFilterT< TestFilter > pipeFilter( "Producer" );
@@ -333,3 +1914,91 @@ BOOST_AUTO_TEST_CASE( testFutureMaps )
                        std::logic_error );
     const tuyau::FutureMap portFutures2( nonUniqueFutures );
 }
+
+BOOST_AUTO_TEST_CASE( testFanInValueRange )
+{
+    // The consumer reads its fan-in input through a ValueRange, in the order
+    // of the connections
+    tuyau::Pipeline pipeline;
+    tuyau::PipeFilter consumer = pipeline.add< ValueRangeFilter >( "Consumer" );
+    for( uint32_t i = 0; i < 3; ++i )
+    {
+        tuyau::PipeFilter producer =
+                pipeline.add< ConvertFilter >( "Producer" + std::to_string( i ));
+        producer.getPromise( "ConvertInputData" ).set( OutputData( i ));
+        producer.connect( "ConvertOutputData", consumer, "TestInputData" );
+    }
+    pipeline.execute();
+
+    const tuyau::UniqueFutureMap portFutures( consumer.getPostconditions( ));
+    const std::vector< uint32_t >& values =
+            portFutures.get< std::vector< uint32_t >>( "Values" );
+    BOOST_CHECK_EQUAL( values.size(), 3 );
+    for( uint32_t i = 0; i < values.size(); ++i )
+        BOOST_CHECK_EQUAL( values[ i ], i + addMoreFish );
+}
+
+BOOST_AUTO_TEST_CASE( testWaitForAny )
+{
+    // The repeated waits on a future, which stays pending, return as the
+    // other futures are set
+    tuyau::Promise pending( tuyau::DataInfo( "Pending", tuyau::getType< uint32_t >( )));
+    for( uint32_t i = 0; i < 100; ++i )
+    {
+        tuyau::Promise promise( tuyau::DataInfo( "Ready", tuyau::getType< uint32_t >( )));
+        std::thread setter( [ & ] { promise.set( i ); });
+        tuyau::waitForAny( { pending.getFuture(), promise.getFuture() });
+        setter.join();
+        BOOST_CHECK( promise.getFuture().isReady( ));
+    }
+
+    BOOST_CHECK( !pending.getFuture().isReady( ));
+    pending.set( 42u );
+    tuyau::waitForAny( { pending.getFuture() });
+    BOOST_CHECK_EQUAL( pending.getFuture().get< uint32_t >(), 42 );
+}
+
+BOOST_AUTO_TEST_CASE( testFutureMapValues )
+{
+    std::vector< tuyau::Promise > promises;
+    tuyau::Futures futures;
+    for( size_t i = 0; i < 3; ++i )
+    {
+        promises.emplace_back( tuyau::DataInfo( "Values", tuyau::getType< uint32_t >( )));
+        futures.push_back( promises.back().getFuture( ));
+    }
+
+    const tuyau::FutureMap futureMap( futures );
+
+    // The values are streamed in completion order
+    std::vector< uint32_t > order;
+    promises[ 2 ].set( 2u );
+    futureMap.forEachReady< uint32_t >( "Values", [ & ]( const uint32_t& value )
+    {
+        order.push_back( value );
+        if( value == 2 )
+            promises[ 0 ].set( 0u );
+        else if( value == 0 )
+            promises[ 1 ].set( 1u );
+    });
+    BOOST_CHECK_EQUAL( order.size(), 3 );
+    BOOST_CHECK_EQUAL( order[ 0 ], 2 );
+    BOOST_CHECK_EQUAL( order[ 1 ], 0 );
+    BOOST_CHECK_EQUAL( order[ 2 ], 1 );
+
+    // The range references the port data
+    uint32_t sum = 0;
+    auto future = futures.begin();
+    for( const uint32_t& value: futureMap.getValues< uint32_t >( "Values" ))
+    {
+        BOOST_CHECK_EQUAL( &value, &( future++ )->get< uint32_t >( ));
+        sum += value;
+    }
+    BOOST_CHECK_EQUAL( sum, 3 );
+
+    const tuyau::ValueRange< uint32_t > values = futureMap.getValues< uint32_t >( "Values" );
+    BOOST_CHECK_EQUAL( values.size(), 3 );
+    BOOST_CHECK_THROW( *futureMap.getValues< float >( "Values" ).begin(),
+                       std::runtime_error );
+    BOOST_CHECK_THROW( futureMap.getValues< uint32_t >( "Unknown" ), std::logic_error );
+}
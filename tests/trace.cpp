@@ -0,0 +1,111 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#define BOOST_TEST_MODULE Trace
+
+#include <tuyau/filter.h>
+#include <tuyau/futureMap.h>
+#include <tuyau/pipeline.h>
+#include <tuyau/promiseMap.h>
+#include <tuyau/pushExecutor.h>
+#include <tuyau/trace.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+
+class IncrementFilter : public tuyau::Filter
+{
+    void execute( const tuyau::FutureMap& input, tuyau::PromiseMap& output ) const final
+    {
+        uint32_t value = 0;
+        for( const uint32_t& inputValue: input.getValues< uint32_t >( "Input" ))
+            value += inputValue + 1;
+        output.set( "Output", value );
+    }
+
+    tuyau::DataInfos getInputDataInfos() const final
+    {
+        return {{ "Input", tuyau::getType< uint32_t >( )}};
+    }
+
+    tuyau::DataInfos getOutputDataInfos() const final
+    {
+        return {{ "Output", tuyau::getType< uint32_t >( )}};
+    }
+};
+
+tuyau::Pipeline createPipeline()
+{
+    tuyau::Pipeline pipeline;
+    tuyau::PipeFilter producer = pipeline.add< IncrementFilter >( "Producer" );
+    tuyau::PipeFilter consumer = pipeline.add< IncrementFilter >( "Consumer" );
+    producer.connect( "Output", consumer, "Input" );
+    producer.getPromise( "Input" ).set( 0u );
+    return pipeline;
+}
+
+BOOST_AUTO_TEST_CASE( testDisabledTrace )
+{
+    tuyau::Trace::disable();
+    tuyau::Trace::clear();
+
+    tuyau::Pipeline pipeline = createPipeline();
+    pipeline.execute();
+
+    std::stringstream json;
+    tuyau::Trace::write( json );
+    BOOST_CHECK_EQUAL( json.str().find( "\"cat\"" ), std::string::npos );
+}
+
+BOOST_AUTO_TEST_CASE( testTraceEvents )
+{
+    tuyau::Trace::clear();
+    tuyau::Trace::enable();
+    {
+        tuyau::Pipeline pipeline = createPipeline();
+        tuyau::PushExecutor executor( 2, "Traced" );
+        pipeline.schedule( executor );
+
+        const tuyau::UniqueFutureMap futures(
+                pipeline.getExecutable( "Consumer" ).getPostconditions( ));
+        BOOST_CHECK_EQUAL( futures.get< uint32_t >( "Output" ), 2 );
+    }
+    tuyau::Trace::disable();
+
+    std::stringstream json;
+    tuyau::Trace::write( json );
+    const std::string trace = json.str();
+
+    BOOST_CHECK_EQUAL( trace.find( "{\"traceEvents\":[" ), 0 );
+    BOOST_CHECK( trace.find( "\"cat\":\"filter\",\"name\":\"Producer\"" ) != std::string::npos );
+    BOOST_CHECK( trace.find( "\"cat\":\"filter\",\"name\":\"Consumer\"" ) != std::string::npos );
+    BOOST_CHECK( trace.find( "\"cat\":\"queue\",\"name\":\"Consumer\"" ) != std::string::npos );
+    BOOST_CHECK( trace.find( "\"cat\":\"executor\",\"name\":\"Consumer\"" ) != std::string::npos );
+    BOOST_CHECK( trace.find( "\"cat\":\"port\",\"name\":\"Output\"" ) != std::string::npos );
+    BOOST_CHECK( trace.find( "\"name\":\"Traced 0\"" ) != std::string::npos ||
+                 trace.find( "\"name\":\"Traced 1\"" ) != std::string::npos );
+    BOOST_CHECK_EQUAL( tuyau::Trace::getDroppedCount(), 0 );
+
+    tuyau::Trace::clear();
+    std::stringstream cleared;
+    tuyau::Trace::write( cleared );
+    BOOST_CHECK_EQUAL( cleared.str().find( "\"cat\"" ), std::string::npos );
+}
@@ -0,0 +1,169 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#define BOOST_TEST_MODULE Workers
+
+#include <tuyau/workers.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE( testFullSharedQueue )
+{
+    // More tasks than the capacity of the bounded queue are submitted from a
+    // worker thread, which must neither block nor execute them inline
+    const size_t nTasks = 20000;
+    tuyau::Workers workers( 1 );
+
+    std::atomic< size_t > executed( 0 );
+    std::atomic< size_t > depth( 0 );
+    std::atomic< size_t > maxDepth( 0 );
+    std::promise< void > done;
+
+    const auto task = [ & ]
+    {
+        const size_t current = ++depth;
+        size_t previous = maxDepth;
+        while( previous < current &&
+               !maxDepth.compare_exchange_weak( previous, current ))
+        {}
+
+        if( ++executed == nTasks + 1 )
+            done.set_value();
+        --depth;
+    };
+
+    workers.submit( [ & ]
+    {
+        task();
+        for( size_t i = 0; i < nTasks; ++i )
+            workers.submit( task );
+    });
+
+    done.get_future().wait();
+    BOOST_CHECK_EQUAL( executed, nTasks + 1 );
+    BOOST_CHECK_EQUAL( maxDepth, 1 );
+}
+
+BOOST_AUTO_TEST_CASE( testFullSharedQueueFromOutside )
+{
+    // A thread out of the workers waits for room in the full queue
+    const size_t nTasks = 20000;
+    std::atomic< size_t > executed( 0 );
+    {
+        tuyau::Workers workers( 2 );
+        for( size_t i = 0; i < nTasks; ++i )
+            workers.submit( [ & ] { ++executed; });
+    }
+    BOOST_CHECK_EQUAL( executed, nTasks );
+}
+
+BOOST_AUTO_TEST_CASE( testStopWithFullSharedQueue )
+{
+    // Once the workers are stopping, the worker submits more tasks than the
+    // capacity of the bounded queue, the others are in its overflow list. All
+    // of them are executed before the thread exits
+    const size_t nTasks = 20000;
+    std::atomic< size_t > executed( 0 );
+    {
+        tuyau::Workers workers( 1 );
+        std::promise< void > started;
+        workers.submit( [ & ]
+        {
+            started.set_value();
+            std::this_thread::sleep_for( std::chrono::milliseconds( 100 ));
+            for( size_t i = 0; i < nTasks; ++i )
+                workers.submit( [ & ] { ++executed; });
+        });
+        started.get_future().wait();
+    }
+    BOOST_CHECK_EQUAL( executed, nTasks );
+}
+
+BOOST_AUTO_TEST_CASE( testAwaitThreadState )
+{
+    // The executables resume on any thread after their awaits, where the state
+    // of the workers has to be the one of the resuming thread. The fibers are
+    // created with a small stack on the first awaits.
+    const size_t nTasks = 100;
+    const size_t nAwaits = 10;
+    const tuyau::Workers::QueueMode queueModes[] = { tuyau::Workers::SHARED_QUEUE,
+                                                     tuyau::Workers::WORK_STEALING };
+    for( const tuyau::Workers::QueueMode queueMode: queueModes )
+    {
+        std::mutex mutex;
+        std::vector< tuyau::WorkerTask > resumes;
+        std::atomic< size_t > finished( 0 );
+        std::atomic< size_t > executed( 0 );
+        std::atomic< size_t > errors( 0 );
+        {
+            tuyau::Workers workers( 4, "Workers", tuyau::WorkerSetupFunc(),
+                                    tuyau::WorkerDestroyFunc(), queueMode,
+                                    tuyau::Workers::Cores(), 64 * 1024 );
+            for( size_t i = 0; i < nTasks; ++i )
+            {
+                workers.submit( [ & ]
+                {
+                    for( size_t j = 0; j < nAwaits; ++j )
+                    {
+                        tuyau::Workers::await( [ & ]( const tuyau::WorkerTask& resume )
+                        {
+                            std::lock_guard< std::mutex > lock( mutex );
+                            resumes.push_back( resume );
+                        });
+
+                        if( tuyau::Workers::getCurrent() != &workers )
+                            ++errors;
+
+                        workers.submit( [ & ]
+                        {
+                            if( tuyau::Workers::getCurrent() == &workers )
+                                ++executed;
+                        });
+                    }
+                    ++finished;
+                });
+            }
+
+            // The operations complete out of the workers
+            while( finished < nTasks )
+            {
+                std::vector< tuyau::WorkerTask > completed;
+                {
+                    std::lock_guard< std::mutex > lock( mutex );
+                    completed.swap( resumes );
+                }
+
+                for( const tuyau::WorkerTask& resume: completed )
+                    resume();
+                std::this_thread::yield();
+            }
+        }
+
+        BOOST_CHECK_EQUAL( errors, 0 );
+        BOOST_CHECK_EQUAL( executed, nTasks * nAwaits );
+    }
+}
@@ -0,0 +1,67 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "arena.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace tuyau
+{
+
+Arena::Arena( const size_t chunkSize )
+    : _chunkSize( chunkSize )
+    , _current( nullptr )
+    , _end( nullptr )
+{}
+
+Arena::~Arena()
+{}
+
+void* Arena::_allocateChunk( const size_t size, const size_t alignment )
+{
+    const size_t chunkSize = std::max( _chunkSize, size + alignment );
+    _chunks.emplace_back( new char[ chunkSize ]);
+    _chunkSizes.push_back( chunkSize );
+    _current = _chunks.back().get();
+    _end = _current + chunkSize;
+    return allocate( size, alignment );
+}
+
+void Arena::release()
+{
+    if( _chunks.size() > 1 )
+    {
+        const size_t capacity = getCapacity();
+        _chunks.clear();
+        _chunkSizes.clear();
+        _chunks.emplace_back( new char[ capacity ]);
+        _chunkSizes.push_back( capacity );
+    }
+
+    _current = _chunks.empty() ? nullptr : _chunks.front().get();
+    _end = _chunks.empty() ? nullptr : _current + _chunkSizes.front();
+}
+
+size_t Arena::getCapacity() const
+{
+    return std::accumulate( _chunkSizes.begin(), _chunkSizes.end(), size_t( 0 ));
+}
+
+}
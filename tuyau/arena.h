@@ -0,0 +1,134 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _Arena_h_
+#define _Arena_h_
+
+#include <tuyau/api.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace tuyau
+{
+
+/**
+ * Monotonic allocator for the short lived objects of a run, i.e. the
+ * bookkeeping of a pipeline execution. The objects are allocated by bumping a
+ * pointer in the current chunk and they are freed all at once by release().
+ * The chunks are kept for the next runs, so the runs allocate from the heap
+ * only when they need more memory than the previous runs. Not thread safe.
+ */
+class Arena
+{
+public:
+
+    /**
+     * @param chunkSize is the minimum size of the chunks allocated from the
+     * heap
+     */
+    TUYAU_API explicit Arena( size_t chunkSize = 4096 );
+    TUYAU_API ~Arena();
+
+    /**
+     * @param size of the object in bytes
+     * @param alignment of the object, a power of two
+     * @return the memory for the object, valid until release()
+     */
+    void* allocate( const size_t size, const size_t alignment )
+    {
+        const uintptr_t current = reinterpret_cast< uintptr_t >( _current );
+        const uintptr_t aligned = ( current + alignment - 1 ) & ~( alignment - 1 );
+        if( aligned + size > reinterpret_cast< uintptr_t >( _end ))
+            return _allocateChunk( size, alignment );
+
+        _current = reinterpret_cast< char* >( aligned + size );
+        return reinterpret_cast< void* >( aligned );
+    }
+
+    /**
+     * Frees all the objects. The destructors of the objects are not called.
+     * If the last run needed multiple chunks, they are replaced by a single
+     * chunk of their total size.
+     */
+    TUYAU_API void release();
+
+    /** @return the total size of the chunks */
+    TUYAU_API size_t getCapacity() const;
+
+    Arena( const Arena& ) = delete;
+    Arena& operator=( const Arena& ) = delete;
+
+private:
+
+    TUYAU_API void* _allocateChunk( size_t size, size_t alignment );
+
+    const size_t _chunkSize;
+    std::vector< std::unique_ptr< char[] >> _chunks;
+    std::vector< size_t > _chunkSizes;
+    char* _current;
+    char* _end;
+};
+
+/**
+ * Standard allocator for the containers, which allocates from an Arena. The
+ * deallocations are no-ops, the memory is freed by Arena::release(), so the
+ * containers should not be used after the release.
+ */
+template< class T >
+struct ArenaAllocator
+{
+    typedef T value_type;
+
+    explicit ArenaAllocator( Arena& arena_ )
+        : arena( &arena_ )
+    {}
+
+    template< class U >
+    ArenaAllocator( const ArenaAllocator< U >& allocator )
+        : arena( allocator.arena )
+    {}
+
+    T* allocate( const size_t n )
+    {
+        return static_cast< T* >( arena->allocate( n * sizeof( T ), alignof( T )));
+    }
+
+    void deallocate( T*, size_t ) {}
+
+    template< class U >
+    bool operator==( const ArenaAllocator< U >& allocator ) const
+    {
+        return arena == allocator.arena;
+    }
+
+    template< class U >
+    bool operator!=( const ArenaAllocator< U >& allocator ) const
+    {
+        return arena != allocator.arena;
+    }
+
+    Arena* arena;
+};
+
+}
+
+#endif // _Arena_h_
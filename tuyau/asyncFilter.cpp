@@ -0,0 +1,48 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "asyncFilter.h"
+#include "workers.h"
+
+namespace tuyau
+{
+
+void AsyncFilter::await( const Future& future )
+{
+    Workers::await( future );
+}
+
+void AsyncFilter::await( const FutureMap& input, const std::string& name )
+{
+    for( const Future& future: input.getFutures( name ))
+        Workers::await( future );
+}
+
+void AsyncFilter::await( const FutureMap& input, const PortHandle& handle )
+{
+    for( const Future& future: input.getFutures( handle ))
+        Workers::await( future );
+}
+
+void AsyncFilter::await( const AsyncStartFunc& start )
+{
+    Workers::await( start );
+}
+
+}
@@ -0,0 +1,78 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _AsyncFilter_h_
+#define _AsyncFilter_h_
+
+#include <tuyau/api.h>
+
+#include "filter.h"
+
+namespace tuyau
+{
+
+/**
+ * Base class for the filters which wait within their execution, i.e. for
+ * I/O completions or for the inputs they need late in the execution. The
+ * waits suspend the execution instead of blocking the worker thread, which
+ * executes other filters meanwhile. The execution resumes on any free worker
+ * thread when the wait is over ( see Workers::await() ). Out of the worker
+ * threads, i.e. in Pipeline::execute(), the waits block.
+ *
+ * As the execution may resume on another thread, the filter should not hold
+ * locks or thread local data across the waits.
+ */
+class AsyncFilter : public Filter
+{
+protected:
+
+    /**
+     * Suspends the execution until the future is ready.
+     * @param future is waited for
+     */
+    TUYAU_API static void await( const Future& future );
+
+    /**
+     * Suspends the execution until the data of the input port is ready.
+     * @param input is the input of the execution
+     * @param name of the input port
+     * @throw std::logic_error when there is no port with the given name
+     */
+    TUYAU_API static void await( const FutureMap& input, const std::string& name );
+
+    /**
+     * Suspends the execution until the data of the input port is ready.
+     * @param input is the input of the execution
+     * @param handle of the input port
+     * @throw std::logic_error when there is no port with the given handle
+     */
+    TUYAU_API static void await( const FutureMap& input, const PortHandle& handle );
+
+    /**
+     * Suspends the execution until an asynchronous operation completes.
+     * @param start starts the operation with the completion callback, which
+     * has to be called once when the operation completes, from any thread.
+     * @throw the exception thrown by start
+     */
+    TUYAU_API static void await( const AsyncStartFunc& start );
+};
+
+}
+
+#endif // _AsyncFilter_h_
@@ -0,0 +1,197 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "blockPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace tuyau
+{
+
+namespace
+{
+
+const size_t nSizeClasses = BlockPool::maxBlockSize / BlockPool::blockAlignment;
+
+// The number of blocks cached per thread and size class, half of them move
+// to the shared free list when the cache is full.
+const size_t maxCachedBlocks = 64;
+const size_t batchSize = maxCachedBlocks / 2;
+
+std::atomic< size_t > allocatedBlocks( 0 );
+
+inline size_t getSizeClass( const size_t size )
+{
+    return ( size + BlockPool::blockAlignment - 1 ) / BlockPool::blockAlignment - 1;
+}
+
+/** The free lists shared by the threads */
+struct SharedFreeLists
+{
+    std::mutex mutex[ nSizeClasses ];
+    std::vector< void* > blocks[ nSizeClasses ];
+};
+
+SharedFreeLists& getSharedFreeLists()
+{
+    // Never destroyed, as the thread caches may be flushed after the
+    // static objects are destroyed
+    static SharedFreeLists* freeLists = new SharedFreeLists;
+    return *freeLists;
+}
+
+/** The free lists of a thread */
+struct ThreadCache
+{
+    ThreadCache()
+    {
+        std::fill( counts, counts + nSizeClasses, 0 );
+    }
+
+    ~ThreadCache()
+    {
+        for( size_t sizeClass = 0; sizeClass < nSizeClasses; ++sizeClass )
+            flush( sizeClass, counts[ sizeClass ]);
+    }
+
+    void* allocate( const size_t sizeClass )
+    {
+        if( counts[ sizeClass ] == 0 && !refill( sizeClass ))
+        {
+            ++allocatedBlocks;
+            return ::operator new(( sizeClass + 1 ) * BlockPool::blockAlignment );
+        }
+        return blocks[ sizeClass ][ --counts[ sizeClass ]];
+    }
+
+    void deallocate( void* block, const size_t sizeClass )
+    {
+        if( counts[ sizeClass ] == maxCachedBlocks )
+            flush( sizeClass, batchSize );
+
+        blocks[ sizeClass ][ counts[ sizeClass ]++ ] = block;
+    }
+
+    /** @return false if there are no shared blocks */
+    bool refill( const size_t sizeClass )
+    {
+        SharedFreeLists& freeLists = getSharedFreeLists();
+        std::lock_guard< std::mutex > lock( freeLists.mutex[ sizeClass ]);
+        std::vector< void* >& shared = freeLists.blocks[ sizeClass ];
+        const size_t count = std::min( batchSize, shared.size( ));
+        std::copy( shared.end() - count, shared.end(), blocks[ sizeClass ]);
+        shared.resize( shared.size() - count );
+        counts[ sizeClass ] = count;
+        return count > 0;
+    }
+
+    void flush( const size_t sizeClass, const size_t count )
+    {
+        if( count == 0 )
+            return;
+
+        void** end = blocks[ sizeClass ] + counts[ sizeClass ];
+        SharedFreeLists& freeLists = getSharedFreeLists();
+        std::lock_guard< std::mutex > lock( freeLists.mutex[ sizeClass ]);
+        freeLists.blocks[ sizeClass ].insert( freeLists.blocks[ sizeClass ].end(),
+                                              end - count, end );
+        counts[ sizeClass ] -= count;
+    }
+
+    void* blocks[ nSizeClasses ][ maxCachedBlocks ];
+    size_t counts[ nSizeClasses ];
+};
+
+/**
+ * The blocks may be freed after the cache of the thread is destroyed ( i.e. by
+ * the destructors of the static objects ), so the cache is referenced through
+ * a trivially destructible thread local.
+ */
+struct ThreadCacheRef
+{
+    ThreadCache* cache;
+    bool destroyed;
+};
+
+thread_local ThreadCacheRef threadCacheRef = { nullptr, false };
+
+struct ThreadCacheHolder
+{
+    ThreadCacheHolder() { threadCacheRef.cache = &cache; }
+    ~ThreadCacheHolder() { threadCacheRef = { nullptr, true }; }
+
+    ThreadCache cache;
+};
+
+ThreadCache* getThreadCache()
+{
+    ThreadCacheRef& ref = threadCacheRef;
+    if( !ref.cache && !ref.destroyed )
+    {
+        static thread_local ThreadCacheHolder holder;
+        (void)holder;
+    }
+    return ref.cache;
+}
+
+}
+
+void* BlockPool::allocate( const size_t size )
+{
+    if( size == 0 || size > maxBlockSize )
+        return ::operator new( size );
+
+    ThreadCache* cache = getThreadCache();
+    if( cache )
+        return cache->allocate( getSizeClass( size ));
+
+    ++allocatedBlocks;
+    return ::operator new(( getSizeClass( size ) + 1 ) * blockAlignment );
+}
+
+void BlockPool::deallocate( void* block, const size_t size )
+{
+    if( size == 0 || size > maxBlockSize )
+    {
+        ::operator delete( block );
+        return;
+    }
+
+    const size_t sizeClass = getSizeClass( size );
+    ThreadCache* cache = getThreadCache();
+    if( cache )
+    {
+        cache->deallocate( block, sizeClass );
+        return;
+    }
+
+    SharedFreeLists& freeLists = getSharedFreeLists();
+    std::lock_guard< std::mutex > lock( freeLists.mutex[ sizeClass ]);
+    freeLists.blocks[ sizeClass ].push_back( block );
+}
+
+size_t BlockPool::getAllocatedBlocks()
+{
+    return allocatedBlocks;
+}
+
+}
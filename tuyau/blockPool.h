@@ -0,0 +1,112 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _BlockPool_h_
+#define _BlockPool_h_
+
+#include <tuyau/api.h>
+
+#include <cstddef>
+#include <new>
+
+namespace tuyau
+{
+
+/**
+ * Allocates small memory blocks from free lists per block size, so that the
+ * frequently created small objects ( i.e. the port data and the future states
+ * of every Promise::set() and Promise::reset() ) are recycled instead of
+ * allocated from the heap. Each thread caches the freed blocks, and the blocks
+ * move in batches between the threads and a shared free list, as the objects
+ * are usually freed by other threads than the ones allocating them. The
+ * blocks are kept for reuse until the process exits. The blocks larger than
+ * maxBlockSize are allocated from the heap.
+ */
+class BlockPool
+{
+public:
+
+    /** The largest block size which is pooled */
+    static const size_t maxBlockSize = 256;
+
+    /** The alignment of the pooled blocks */
+    static const size_t blockAlignment = 16;
+
+    /**
+     * @param size of the block in bytes
+     * @return the block
+     * @throw std::bad_alloc when the allocation fails
+     */
+    TUYAU_API static void* allocate( size_t size );
+
+    /**
+     * Returns the block to the pool.
+     * @param block is allocated with allocate()
+     * @param size is the size given to allocate()
+     */
+    TUYAU_API static void deallocate( void* block, size_t size );
+
+    /**
+     * @return the number of the pooled blocks allocated from the heap, i.e.
+     * to check the reuse of the blocks.
+     */
+    TUYAU_API static size_t getAllocatedBlocks();
+};
+
+/**
+ * Standard allocator, which allocates the single objects from the BlockPool,
+ * i.e. for std::allocate_shared(). The objects with larger alignment than
+ * BlockPool::blockAlignment are allocated from the heap.
+ */
+template< class T >
+struct PoolAllocator
+{
+    typedef T value_type;
+
+    PoolAllocator() {}
+
+    template< class U >
+    PoolAllocator( const PoolAllocator< U >& ) {}
+
+    T* allocate( const size_t n )
+    {
+        if( n != 1 || alignof( T ) > BlockPool::blockAlignment )
+            return static_cast< T* >( ::operator new( n * sizeof( T )));
+
+        return static_cast< T* >( BlockPool::allocate( sizeof( T )));
+    }
+
+    void deallocate( T* object, const size_t n )
+    {
+        if( n != 1 || alignof( T ) > BlockPool::blockAlignment )
+            ::operator delete( object );
+        else
+            BlockPool::deallocate( object, sizeof( T ));
+    }
+
+    template< class U >
+    bool operator==( const PoolAllocator< U >& ) const { return true; }
+
+    template< class U >
+    bool operator!=( const PoolAllocator< U >& ) const { return false; }
+};
+
+}
+
+#endif // _BlockPool_h_
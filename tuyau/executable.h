@@ -40,6 +40,24 @@ public:
     /** Executes the executable */
     virtual void execute() =  0;
 
+    /**
+     * @return the name of the executable ( i.e. for tracing ), empty if it
+     * has no name
+     */
+    TUYAU_API virtual std::string getName() const { return std::string(); }
+
+    /**
+     * @return the estimated size in bytes of the outputs of the executable,
+     * 0 if it is not known
+     */
+    TUYAU_API virtual size_t getEstimatedOutputSize() const { return 0; }
+
+    /**
+     * @return the priority of the executable for scheduling ( see
+     * PriorityPolicy ), higher priorities are executed first
+     */
+    TUYAU_API virtual int getPriority() const { return 0; }
+
     /**
      * Schedules the executable through an Executor
      * @param executor schedules the executable
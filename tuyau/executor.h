@@ -46,6 +46,14 @@ public:
      */
     virtual void schedule( ExecutablePtr executable ) = 0;
 
+    /**
+     * Sets the policy which orders the ready executables. The executors,
+     * which do not queue the ready executables, ignore the policy.
+     * @param policy orders the ready executables, an empty policy restores
+     * the default order of the executor.
+     */
+    TUYAU_API virtual void setSchedulingPolicy( SchedulingPolicyPtr policy ) { (void)policy; }
+
 protected:
 
     /** Clears the executor ( i.e : Implementation can empty the work queue ) */
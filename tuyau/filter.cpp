@@ -0,0 +1,50 @@
+
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "filter.h"
+
+namespace tuyau
+{
+
+namespace
+{
+
+PortHandle getHandle( const DataInfos& dataInfos, const std::string& name )
+{
+    const auto it = dataInfos.find( name );
+    if( it == dataInfos.end( ))
+        throw std::logic_error( std::string( "Unknown port name: ") + name );
+
+    return PortHandle( std::distance( dataInfos.begin(), it ));
+}
+
+}
+
+PortHandle Filter::getInputHandle( const std::string& name ) const
+{
+    return getHandle( getInputDataInfos(), name );
+}
+
+PortHandle Filter::getOutputHandle( const std::string& name ) const
+{
+    return getHandle( getOutputDataInfos(), name );
+}
+
+}
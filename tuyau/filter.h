@@ -61,6 +61,42 @@ public:
      */
     TUYAU_API virtual DataInfos getOutputDataInfos() const { return DataInfos(); }
 
+    /**
+     * @return true if the outputs of the filter only depend on its inputs, so
+     * that the outputs can be cached for the same inputs ( see
+     * PipeFilter::setCacheSize() )
+     */
+    TUYAU_API virtual bool isPure() const { return false; }
+
+    /**
+     * @return the estimated size in bytes of the outputs of one execution,
+     * which is used for scheduling within a memory budget ( see
+     * PushExecutor::setMemoryBudget() ), 0 if it is not known
+     */
+    TUYAU_API virtual size_t getEstimatedOutputSize() const { return 0; }
+
+    /**
+     * Resolves the handle of an input port, which can be used instead of the
+     * port name with the FutureMap at execution time. As the port infos are
+     * virtual, it can be called in the constructor of the class which defines
+     * them, but not in the constructors of its base classes.
+     * @param name of the input port
+     * @return the handle of the port
+     * @throw std::logic_error when there is no input port with the given name
+     */
+    TUYAU_API PortHandle getInputHandle( const std::string& name ) const;
+
+    /**
+     * Resolves the handle of an output port, which can be used instead of the
+     * port name with the PromiseMap at execution time. As the port infos are
+     * virtual, it can be called in the constructor of the class which defines
+     * them, but not in the constructors of its base classes.
+     * @param name of the output port
+     * @return the handle of the port
+     * @throw std::logic_error when there is no output port with the given name
+     */
+    TUYAU_API PortHandle getOutputHandle( const std::string& name ) const;
+
     TUYAU_API virtual ~Filter() {}
 };
 
@@ -18,15 +18,22 @@
  */
 
 #include "futureMap.h"
+#include "inputPort.h"
 
 namespace tuyau
 {
-namespace
+
+/** The futures of a port, either owned by the map or by an input port */
+struct PortFutures
 {
-const std::string ALL_FUTURES = "ALL_FUTURES";
-}
+    bool operator<( const PortFutures& rhs ) const
+    {
+        return name < rhs.name;
+    }
 
-typedef std::multimap< std::string, Future > NameFutureMap;
+    std::string name;
+    const Futures* futures;
+};
 
 struct FutureMapImpl
 {
@@ -39,34 +46,42 @@ public:
 
     bool hasFuture( const std::string& name ) const
     {
-        return _futureMap.count( name ) > 0;
+        return _ownedFutures.count( name ) > 0;
     }
 
-    Futures getFutures( const std::string& name ) const
+    const Futures& getFutures( const std::string& name ) const
     {
-        if( name == ALL_FUTURES )
-        {
-            Futures futures;
-            for( const auto& nameFuture: _futureMap )
-                futures.push_back( nameFuture.second );
-            return futures;
-        }
-
-        if( !hasFuture( name ))
+        const PortFutures key = { name, nullptr };
+        const auto it = std::lower_bound( _ports.begin(), _ports.end(), key );
+        if( it == _ports.end() || it->name != name || it->futures->empty( ))
             throwError( name );
 
-        Futures futures;
-        const auto& itPair = _futureMap.equal_range( name );
+        return *it->futures;
+    }
 
-        for( auto it = itPair.first; it != itPair.second; ++it )
-            futures.push_back( it->second );
+    const Futures& getFutures( const PortHandle& handle ) const
+    {
+        if( handle.index >= _ports.size() ||
+            _ports[ handle.index ].futures->empty( ))
+        {
+            throw std::logic_error( std::string( "Unknown port handle: ")
+                                    + std::to_string( handle.index ));
+        }
+        return *_ports[ handle.index ].futures;
+    }
 
+    Futures getFutures() const
+    {
+        Futures futures;
+        for( const auto& port: _ports )
+            futures.insert( futures.end(), port.futures->begin(),
+                            port.futures->end( ));
         return futures;
     }
 
-    bool isReady( const std::string& name ) const
+    static bool isReady( const Futures& futures )
     {
-        for( const auto& future: getFutures( name ))
+        for( const auto& future: futures )
         {
             if( !future.isReady())
                 return false;
@@ -74,23 +89,31 @@ public:
         return true;
     }
 
-    void wait( const std::string& name ) const
+    static void wait( const Futures& futures )
     {
-        for( const auto& future: getFutures( name ))
+        for( const auto& future: futures )
             future.wait();
     }
 
-    void waitForAny( const std::string& name ) const
+    void addFuture( const std::string& name, const Future& future )
     {
-        tuyau::waitForAny( getFutures( name ));
+        _ownedFutures[ name ].push_back( future );
     }
 
-    void addFuture( const std::string& name, const Future& future )
+    void addPort( const std::string& name, const Futures& futures )
+    {
+        _ports.push_back({ name, &futures });
+    }
+
+    /** Ports are ordered by name, which gives the port handles */
+    void addOwnedPorts()
     {
-        _futureMap.insert( std::make_pair( name, future ));
+        for( const auto& nameFutures: _ownedFutures )
+            addPort( nameFutures.first, nameFutures.second );
     }
 
-    NameFutureMap _futureMap;
+    std::map< std::string, Futures > _ownedFutures;
+    std::vector< PortFutures > _ports;
 };
 
 struct UniqueFutureMap::Impl: public FutureMapImpl
@@ -105,6 +128,7 @@ public:
                 throwError( name );
             addFuture( name, future );
         }
+        addOwnedPorts();
     }
 };
 
@@ -114,7 +138,7 @@ UniqueFutureMap::UniqueFutureMap( const Futures& futures )
 
 Futures UniqueFutureMap::getFutures() const
 {
-    return _impl->getFutures( ALL_FUTURES );
+    return _impl->getFutures();
 }
 
 Future UniqueFutureMap::getFuture( const std::string& name ) const
@@ -124,17 +148,17 @@ Future UniqueFutureMap::getFuture( const std::string& name ) const
 
 bool UniqueFutureMap::isReady( const std::string& name ) const
 {
-    return _impl->isReady( name );
+    return _impl->isReady( _impl->getFutures( name ));
 }
 
 void UniqueFutureMap::wait( const std::string& name ) const
 {
-    _impl->wait( name );
+    _impl->wait( _impl->getFutures( name ));
 }
 
 void UniqueFutureMap::waitForAny() const
 {
-    _impl->waitForAny( ALL_FUTURES );
+    tuyau::waitForAny( _impl->getFutures( ));
 }
 
 UniqueFutureMap::~UniqueFutureMap()
@@ -147,7 +171,49 @@ public:
     {
         for( const auto& future: futures )
             addFuture( future.getName(), future );
+        addOwnedPorts();
+    }
+
+    Impl( const std::vector< const InputPort* >& ports )
+        : _inputPorts( ports )
+        , _portFutures( ports.size( ))
+    {
+        std::sort( _inputPorts.begin(), _inputPorts.end(),
+                   []( const InputPort* lhs, const InputPort* rhs )
+                   { return lhs->getName() < rhs->getName(); });
+
+        for( size_t i = 0; i < _inputPorts.size(); ++i )
+            addPort( _inputPorts[ i ]->getName(), _portFutures[ i ]);
+        update();
+    }
+
+    void update()
+    {
+        for( size_t i = 0; i < _inputPorts.size(); ++i )
+        {
+            const Futures& futures = _inputPorts[ i ]->getFutures();
+            Futures& renamed = _portFutures[ i ];
+            if( isUpdated( futures, renamed ))
+                continue;
+
+            const std::string& name = _ports[ i ].name;
+            renamed.clear();
+            for( const auto& future: futures )
+                renamed.emplace_back( future, name );
+        }
+    }
+
+    /** @return true if the renamed futures belong to the same promise values */
+    static bool isUpdated( const Futures& futures, const Futures& renamed )
+    {
+        return futures.size() == renamed.size() &&
+               std::equal( futures.begin(), futures.end(), renamed.begin(),
+                           []( const Future& future, const Future& renamedFuture )
+                           { return future.getId() == renamedFuture.getId(); });
     }
+
+    std::vector< const InputPort* > _inputPorts;
+    std::vector< Futures > _portFutures;
 };
 
 FutureMap::FutureMap( const Futures& futures )
@@ -155,49 +221,77 @@ FutureMap::FutureMap( const Futures& futures )
 {
 }
 
-Futures FutureMap::getFutures( const std::string& name ) const
+FutureMap::FutureMap( const std::vector< const InputPort* >& ports )
+    : _impl( new FutureMap::Impl( ports ))
+{
+}
+
+void FutureMap::_update()
+{
+    _impl->update();
+}
+
+const Futures& FutureMap::getFutures( const std::string& name ) const
 {
     return _impl->getFutures( name );
 }
 
+const Futures& FutureMap::getFutures( const PortHandle& handle ) const
+{
+    return _impl->getFutures( handle );
+}
+
 Futures FutureMap::getFutures() const
 {
-    return _impl->getFutures( ALL_FUTURES );
+    return _impl->getFutures();
 }
 
 bool FutureMap::isReady( const std::string& name ) const
 {
-    return _impl->isReady( name );
+    return _impl->isReady( _impl->getFutures( name ));
+}
+
+bool FutureMap::isReady( const PortHandle& handle ) const
+{
+    return _impl->isReady( _impl->getFutures( handle ));
 }
 
 bool FutureMap::isReady() const
 {
-    return _impl->isReady( ALL_FUTURES );
+    return _impl->isReady( _impl->getFutures( ));
 }
 
 void FutureMap::wait( const std::string& name ) const
 {
-    _impl->wait( name );
+    _impl->wait( _impl->getFutures( name ));
+}
+
+void FutureMap::wait( const PortHandle& handle ) const
+{
+    _impl->wait( _impl->getFutures( handle ));
 }
 
 void FutureMap::wait() const
 {
-    _impl->wait( ALL_FUTURES );
+    _impl->wait( _impl->getFutures( ));
 }
 
 void FutureMap::waitForAny( const std::string& name ) const
 {
-    _impl->waitForAny( name );
+    tuyau::waitForAny( _impl->getFutures( name ));
+}
+
+void FutureMap::waitForAny( const PortHandle& handle ) const
+{
+    tuyau::waitForAny( _impl->getFutures( handle ));
 }
 
 void FutureMap::waitForAny() const
 {
-    _impl->waitForAny( ALL_FUTURES );
+    tuyau::waitForAny( _impl->getFutures( ));
 }
 
 FutureMap::~FutureMap()
 {}
 
-
-
 }
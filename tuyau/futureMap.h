@@ -25,9 +25,80 @@
 #include "types.h"
 #include "futurePromise.h"
 
+#include <iterator>
+
 namespace tuyau
 {
 
+/**
+ * Range over the values of a list of futures. The values are accessed by
+ * reference, so iterating the range neither copies the values nor allocates.
+ * Dereferencing an iterator blocks until the future is ready. The range is
+ * valid while the futures are not reset.
+ */
+template< class T >
+class ValueRange
+{
+public:
+
+    class const_iterator
+    {
+    public:
+
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T* pointer;
+        typedef const T& reference;
+
+        explicit const_iterator( const Futures::const_iterator& it )
+            : _it( it )
+        {}
+
+        /**
+         * @throw std::runtime_error when the data is not exact type T
+         */
+        const T& operator*() const { return _it->get< T >(); }
+        const T* operator->() const { return &_it->get< T >(); }
+
+        const_iterator& operator++()
+        {
+            ++_it;
+            return *this;
+        }
+
+        const_iterator operator++( int )
+        {
+            const const_iterator it = *this;
+            ++_it;
+            return it;
+        }
+
+        bool operator==( const const_iterator& rhs ) const { return _it == rhs._it; }
+        bool operator!=( const const_iterator& rhs ) const { return _it != rhs._it; }
+
+    private:
+
+        Futures::const_iterator _it;
+    };
+
+    /**
+     * @param futures are referenced by the range
+     */
+    explicit ValueRange( const Futures& futures )
+        : _futures( futures )
+    {}
+
+    const_iterator begin() const { return const_iterator( _futures.begin( )); }
+    const_iterator end() const { return const_iterator( _futures.end( )); }
+    size_t size() const { return _futures.size(); }
+    bool empty() const { return _futures.empty(); }
+
+private:
+
+    const Futures& _futures;
+};
+
 /**
  * FutureMap is a wrapper class to query the map of ( name, future )
  * futures with for data and state. In the map there can be multiple futures
@@ -50,6 +121,16 @@ public:
      * future names are used for name-future association.
      */
     TUYAU_API explicit FutureMap( const Futures& futures );
+
+    /**
+     * The futures of the ports are named with the port names. They are copied
+     * once, and updated when the connections of the ports change or the
+     * connected promises are reset ( see _update() ). The ports should outlive
+     * the map.
+     * @param ports are the input ports. The port handles are the positions of
+     * the ports in the name order.
+     */
+    TUYAU_API explicit FutureMap( const std::vector< const InputPort* >& ports );
     TUYAU_API ~FutureMap();
 
     /**
@@ -65,13 +146,77 @@ public:
     template< class T >
     std::vector< T > get( const std::string& name ) const
     {
+        const Futures& futures = getFutures( name );
         std::vector< T > results;
-        for( const auto& future: getFutures( name ))
+        results.reserve( futures.size( ));
+        for( const auto& future: futures )
             results.push_back( future.get< T >( ));
 
         return results;
     }
 
+    /**
+     * Gets the value(s) with the given type T without copying them. The
+     * iteration blocks on each future until it is ready.
+     * @param name of the future.
+     * @return the range of values of the futures.
+     * @throw std::logic_error when there is no future associated with the
+     * given name
+     */
+    template< class T >
+    ValueRange< T > getValues( const std::string& name ) const
+    {
+        return ValueRange< T >( getFutures( name ));
+    }
+
+    /**
+     * Gets the value(s) with the given type T without copying them. The
+     * iteration blocks on each future until it is ready.
+     * @param handle of the port.
+     * @return the range of values of the futures.
+     * @throw std::logic_error when there is no future associated with the
+     * given handle
+     */
+    template< class T >
+    ValueRange< T > getValues( const PortHandle& handle ) const
+    {
+        return ValueRange< T >( getFutures( handle ));
+    }
+
+    /**
+     * Calls the function with the value(s) of type T in the order the
+     * futures become ready. The values are not copied.
+     * @param name of the future.
+     * @param func is called with const T& for each value
+     * @throw std::logic_error when there is no future associated with the
+     * given name
+     * @throw std::runtime_error when the data is not exact
+     * type T
+     */
+    template< class T, class F >
+    void forEachReady( const std::string& name, const F& func ) const
+    {
+        tuyau::forEachReady( getFutures( name ), [ &func ]( const Future& future )
+                             { func( future.get< T >( )); });
+    }
+
+    /**
+     * Calls the function with the value(s) of type T in the order the
+     * futures become ready. The values are not copied.
+     * @param handle of the port.
+     * @param func is called with const T& for each value
+     * @throw std::logic_error when there is no future associated with the
+     * given handle
+     * @throw std::runtime_error when the data is not exact
+     * type T
+     */
+    template< class T, class F >
+    void forEachReady( const PortHandle& handle, const F& func ) const
+    {
+        tuyau::forEachReady( getFutures( handle ), [ &func ]( const Future& future )
+                             { func( future.get< T >( )); });
+    }
+
     /**
      * Gets the copy of ready value(s) with the given type T.
      * @param name of the future.
@@ -95,11 +240,66 @@ public:
         return results;
     }
 
+    /**
+     * Gets a copy of value(s) with the given type T. Until all
+     * futures of the port are ready, this function will block.
+     * @param handle of the port.
+     * @return the values of the futures.
+     * @throw std::logic_error when there is no future associated with the
+     * given handle
+     * @throw std::runtime_error when the data is not exact
+     * type T
+     */
+    template< class T >
+    std::vector< T > get( const PortHandle& handle ) const
+    {
+        const Futures& futures = getFutures( handle );
+        std::vector< T > results;
+        results.reserve( futures.size( ));
+        for( const auto& future: futures )
+            results.push_back( future.get< T >( ));
+
+        return results;
+    }
+
+    /**
+     * Gets the copy of ready value(s) with the given type T.
+     * @param handle of the port.
+     * @return the values of the futures.
+     * @throw std::logic_error when there is no future associated with the
+     * given handle
+     * @throw std::runtime_error when the data is not exact
+     * type T
+     */
+    template< class T >
+    std::vector< T > getReady( const PortHandle& handle ) const
+    {
+        std::vector< T > results;
+        for( const auto& future: getFutures( handle ))
+        {
+            if( !future.isReady())
+                continue;
+
+            results.push_back( future.get< T >( ));
+        }
+        return results;
+    }
+
     /**
      * @param name of the future.
-     * @return the futures with the given name
+     * @return the futures with the given name, without copying them
+     * @throw std::logic_error when there is no future associated with the
+     * given name
      */
-    TUYAU_API Futures getFutures( const std::string& name ) const;
+    TUYAU_API const Futures& getFutures( const std::string& name ) const;
+
+    /**
+     * @param handle of the port.
+     * @return the futures of the port, without copying them
+     * @throw std::logic_error when there is no future associated with the
+     * given handle
+     */
+    TUYAU_API const Futures& getFutures( const PortHandle& handle ) const;
 
     /**
      * @return the futures
@@ -115,6 +315,15 @@ public:
      */
     TUYAU_API bool isReady( const std::string& name ) const;
 
+    /**
+     * Queries if futures of a port are ready
+     * @param handle of the port.
+     * @return true if all futures of the port are ready.
+     * @throw std::logic_error when there is no future associated with the
+     * given handle
+     */
+    TUYAU_API bool isReady( const PortHandle& handle ) const;
+
     /**
      * Queries if all futures are ready
      * @return true if all futures are ready.
@@ -131,6 +340,14 @@ public:
      */
     TUYAU_API void wait( const std::string& name ) const;
 
+    /**
+     * Waits all futures of a port
+     * @param handle of the port.
+     * @throw std::logic_error when there is no future associated with the
+     * given handle
+     */
+    TUYAU_API void wait( const PortHandle& handle ) const;
+
     /**
      * Waits all futures
      * @throw std::runtime_error when there is no future associated with the
@@ -146,6 +363,14 @@ public:
      */
     TUYAU_API void waitForAny( const std::string& name ) const;
 
+    /**
+     * Waits any future of a port.
+     * @param handle of the port.
+     * @throw std::logic_error when there is no future associated with the
+     * given handle
+     */
+    TUYAU_API void waitForAny( const PortHandle& handle ) const;
+
     /**
      * Waits all futures.
      * @throw std::logic_error when there is no future associated with the
@@ -155,6 +380,14 @@ public:
 
 private:
 
+    friend class PipeFilter;
+
+    /**
+     * Renames again the futures of the input ports, whose connections changed
+     * or whose promises are reset since the last update. Not thread safe.
+     */
+    void _update();
+
     struct Impl;
     std::shared_ptr<Impl> _impl;
 };
@@ -18,39 +18,248 @@
  */
 
 #include "futurePromise.h"
+#include "executable.h"
+#include "trace.h"
 
-#include <boost/uuid/uuid.hpp>
-#include <boost/uuid/random_generator.hpp>
-#include <boost/uuid/uuid_io.hpp>
-#include <boost/thread/future.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <ostream>
 
 namespace tuyau
 {
 
-using namespace boost::uuids;
-
 namespace
 {
-inline uuid make_UUID()
-{
-    return boost::uuids::random_generator()();
+std::atomic< uint64_t > nextId( 0 );
 
+/** @return a process wide unique identifier for a promise value */
+inline uint64_t makeId()
+{
+    return ++nextId;
 }
+
+enum Status
+{
+    STATUS_EMPTY,
+    STATUS_SETTING,
+    STATUS_READY
+};
+
+/** A callback of a FutureState, with the owner which may remove it */
+struct OwnedCallback
+{
+    ReadyCallback callback;
+    const void* owner;
+};
+
+/** The threads and callbacks waiting for a FutureState */
+struct Waiters
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector< OwnedCallback > callbacks;
+};
+
+/** Executes a continuation of a future ( see Future::then() ) */
+class ContinuationExecutable : public Executable
+{
+public:
+
+    ContinuationExecutable( const Future& future,
+                            const ContinuationFunc& callback )
+        : _future( future )
+        , _callback( callback )
+        , _done( DataInfo( "Continuation", getType< void >( )))
+    {}
+
+    void execute() final
+    {
+        try
+        {
+            _callback( _future );
+        }
+        catch( ... )
+        {
+            _done.flush();
+            throw;
+        }
+        _done.flush();
+    }
+
+    std::string getName() const final { return "Continuation of " + _future.getName(); }
+    Futures getPostconditions() const final { return { _done.getFuture() }; }
+    Futures getPreconditions() const final { return { _future }; }
+    ExecutablePtr clone() const final
+    {
+        return ExecutablePtr( new ContinuationExecutable( _future, _callback ));
+    }
+
+private:
+
+    const Future _future;
+    const ContinuationFunc _callback;
+    Promise _done;
+};
 }
 
-typedef boost::shared_future< PortDataPtr > PortDataFuture;
-typedef boost::promise< PortDataPtr > PortDataPromise;
-typedef std::vector< PortDataFuture > PortDataFutures;
+/**
+ * The single assignment slot for one value of a promise, shared with its
+ * futures. The waiters are only created when a thread blocks on the state or
+ * a callback is registered.
+ */
+struct FutureState
+{
+    explicit FutureState( const uint64_t id )
+        : _status( STATUS_EMPTY )
+        , _released( false )
+        , _waiters( nullptr )
+        , _id( id )
+    {}
+
+    ~FutureState()
+    {
+        delete _waiters.load();
+    }
+
+    bool isReady() const
+    {
+        return _status.load() == STATUS_READY;
+    }
+
+    /** @return false if the state is already set */
+    bool set( const PortDataPtr& data )
+    {
+        uint32_t expected = STATUS_EMPTY;
+        if( !_status.compare_exchange_strong( expected, STATUS_SETTING ))
+            return false;
+
+        _data = data;
+        _status.store( STATUS_READY );
+
+        // If a waiter is created after this point, it sees the ready status
+        Waiters* waiters = _waiters.load();
+        if( !waiters )
+            return true;
 
+        std::vector< OwnedCallback > callbacks;
+        {
+            std::lock_guard< std::mutex > lock( waiters->mutex );
+            callbacks.swap( waiters->callbacks );
+            waiters->condition.notify_all();
+        }
+
+        for( const auto& callback: callbacks )
+            callback.callback();
+        return true;
+    }
+
+    void wait() const
+    {
+        if( isReady( ))
+            return;
+
+        Waiters& waiters = getWaiters();
+        std::unique_lock< std::mutex > lock( waiters.mutex );
+        waiters.condition.wait( lock, [ this ]{ return isReady(); });
+    }
+
+    /**
+     * @param callback is called once the state is ready
+     * @param owner identifies the callback for removeCallbacks(), if not null
+     */
+    void onReady( const ReadyCallback& callback, const void* owner = nullptr ) const
+    {
+        if( !isReady( ))
+        {
+            Waiters& waiters = getWaiters();
+            std::lock_guard< std::mutex > lock( waiters.mutex );
+            if( !isReady( ))
+            {
+                waiters.callbacks.push_back( { callback, owner });
+                return;
+            }
+        }
+        callback();
+    }
+
+    /**
+     * Removes the callbacks of the owner, which are not called yet. The
+     * callbacks already taken by set() may still be called.
+     */
+    void removeCallbacks( const void* owner ) const
+    {
+        Waiters* waiters = _waiters.load();
+        if( !waiters )
+            return;
+
+        std::lock_guard< std::mutex > lock( waiters->mutex );
+        auto& callbacks = waiters->callbacks;
+        callbacks.erase( std::remove_if( callbacks.begin(), callbacks.end(),
+                                         [ owner ]( const OwnedCallback& callback )
+                                         { return callback.owner == owner; }),
+                         callbacks.end( ));
+    }
+
+    const PortDataPtr& get() const
+    {
+        wait();
+        return _data;
+    }
+
+    /** Drops the data of a ready state, the state stays ready */
+    bool release()
+    {
+        if( !isReady( ))
+            return false;
+
+        _released = true;
+        _data.reset();
+        return true;
+    }
+
+    Waiters& getWaiters() const
+    {
+        Waiters* waiters = _waiters.load();
+        if( waiters )
+            return *waiters;
+
+        Waiters* created = new Waiters;
+        if( _waiters.compare_exchange_strong( waiters, created ))
+            return *created;
+
+        delete created;
+        return *waiters;
+    }
+
+    std::atomic< uint32_t > _status;
+    std::atomic< bool > _released;
+    PortDataPtr _data;
+    mutable std::atomic< Waiters* > _waiters;
+    const uint64_t _id;
+};
+
+typedef std::shared_ptr< FutureState > FutureStatePtr;
+
+namespace
+{
+/** @return a new state for a promise value, allocated from the BlockPool */
+FutureStatePtr makeState()
+{
+    return std::allocate_shared< FutureState >( PoolAllocator< FutureState >(), makeId( ));
+}
+}
 
 struct Future::Impl
 {
-    Impl( const PortDataFuture& future,
+    Impl( const FutureStatePtr& state,
           const std::string& name,
-          const uuid& uuid )
+          const bool followsPromise )
         : _name( name )
-        , _future( future )
-        , _uuid( uuid )
+        , _state( state )
+        , _followsPromise( followsPromise )
     {}
 
     std::string getName() const
@@ -60,10 +269,14 @@ struct Future::Impl
 
     PortDataPtr get( const std::type_index& dataType ) const
     {
-        const PortDataPtr& data = _future.get();
+        const PortDataPtr& data = _state->get();
 
         if( !data )
+        {
+            if( _state->_released )
+                throw std::runtime_error( "Data is released: " + _name );
             throw std::runtime_error( "Returns empty data" );
+        }
 
         if( data->dataType != dataType )
             throw std::runtime_error( "Types does not match on get value");
@@ -73,28 +286,34 @@ struct Future::Impl
 
     bool isReady() const
     {
-        return _future.is_ready();
+        return _state->isReady();
     }
 
     void wait() const
     {
-        return _future.wait();
+        _state->wait();
     }
 
-    std::string _name;
-    mutable PortDataFuture _future;
-    uuid _uuid;
+    void onReady( const ReadyCallback& callback ) const
+    {
+        _state->onReady( callback );
+    }
+
+    const std::string _name;
+    FutureStatePtr _state;
+
+    // The impl of the future constructed from the promise is updated on
+    // Promise::reset(), others are immutable and shared between copies
+    const bool _followsPromise;
 };
 
 struct Promise::Impl
 {
     Impl( const DataInfo& dataInfo )
         : _dataInfo( dataInfo )
-        , _uuid( make_UUID( ))
-        , _futureImpl( new Future::Impl(
-                           PortDataFuture( _promise.get_future()),
-                                           dataInfo.first,
-                                           _uuid ))
+        , _state( makeState( ))
+        , _futureImpl( new Future::Impl( _state, dataInfo.first, true ))
+        , _hasCallbacks( false )
     {}
 
     std::string getName() const
@@ -115,47 +334,64 @@ struct Promise::Impl
                 throw std::runtime_error( "Types does not match on set value");
         }
 
-        try
-        {
-            _promise.set_value( data );
-        }
-        catch( const boost::promise_already_satisfied& )
-        {
+        if( !_state->set( data ))
             throw std::runtime_error( "Data only can be set once");
-        }
+
+        if( Trace::isEnabled( ))
+            Trace::instant( "port", _dataInfo.first );
     }
 
-    void reset()
+    /** @return true if the state was not set and is flushed */
+    bool reset()
     {
-        try
-        {
-            _promise.set_value( PortDataPtr( ));
-        }
-        catch( const boost::promise_already_satisfied& )
-        {
-        }
+        const bool flushed = flush();
+        _state = makeState();
+        _futureImpl->_state = _state;
+        return flushed;
+    }
+
+    /** @return false if the state is already set */
+    bool flush()
+    {
+        if( !_state->set( PortDataPtr( )))
+            return false;
 
-        PortDataPromise promise;
-        _promise.swap( promise );
-        _uuid = make_UUID();
-        _futureImpl->_future = _promise.get_future();
-        _futureImpl->_uuid = _uuid;
+        if( Trace::isEnabled( ))
+            Trace::instant( "port", _dataInfo.first );
+        return true;
     }
 
-    void flush()
+    void addCallback( const ContinuationFunc& callback )
     {
-        try
+        std::lock_guard< std::mutex > lock( _callbacksMutex );
+        _callbacks.push_back( callback );
+        _hasCallbacks = true;
+    }
+
+    void notify( const Future& future )
+    {
+        std::vector< ContinuationFunc > callbacks;
         {
-            _promise.set_value( PortDataPtr( ));
+            std::lock_guard< std::mutex > lock( _callbacksMutex );
+            callbacks = _callbacks;
         }
-        catch( const boost::promise_already_satisfied& )
-        {}
+
+        for( const auto& callback: callbacks )
+            callback( future );
+    }
+
+    void release()
+    {
+        if( _state->release() && Trace::isEnabled( ))
+            Trace::instant( "release", _dataInfo.first );
     }
 
-    PortDataPromise _promise;
     const DataInfo _dataInfo;
-    uuid _uuid;
+    FutureStatePtr _state;
     std::shared_ptr< Future::Impl > _futureImpl;
+    std::atomic< bool > _hasCallbacks;
+    std::mutex _callbacksMutex;
+    std::vector< ContinuationFunc > _callbacks;
 };
 
 Promise::Promise( const DataInfo& dataInfo )
@@ -177,7 +413,8 @@ std::string Promise::getName() const
 
 void Promise::flush()
 {
-    _impl->flush();
+    if( _impl->flush( ))
+        _notify();
 }
 
 Future Promise::getFuture() const
@@ -188,12 +425,45 @@ Future Promise::getFuture() const
 
 void Promise::reset()
 {
-    _impl->reset();
+    // The flushed future is notified, the futures of the promise follow the
+    // new value
+    if( !_impl->_hasCallbacks )
+    {
+        _impl->reset();
+        return;
+    }
+
+    const Future future = getFuture();
+    if( _impl->reset( ))
+        _impl->notify( future );
+}
+
+void Promise::release()
+{
+    _impl->release();
+}
+
+void Promise::onSet( const ContinuationFunc& callback )
+{
+    _impl->addCallback( callback );
+}
+
+void Promise::setPortData( const PortDataPtr& data )
+{
+    _impl->set( data );
+    _notify();
 }
 
 void Promise::_set( PortDataPtr data )
 {
     _impl->set( data );
+    _notify();
+}
+
+void Promise::_notify()
+{
+    if( _impl->_hasCallbacks )
+        _impl->notify( getFuture( ));
 }
 
 Future::Future( const Promise& promise )
@@ -201,9 +471,12 @@ Future::Future( const Promise& promise )
 {}
 
 Future::Future( const Future& future )
-    : _impl( new Future::Impl( future._impl->_future,
-                               future.getName( ),
-                               future._impl->_uuid ))
+    : _impl( future._impl->_followsPromise
+             ? std::allocate_shared< Future::Impl >( PoolAllocator< Future::Impl >(),
+                                                     future._impl->_state,
+                                                     future.getName(),
+                                                     false )
+             : future._impl )
 {}
 
 Future::~Future()
@@ -215,7 +488,12 @@ std::string Future::getName() const
 }
 
 Future::Future( const Future& future, const std::string& name )
-    : _impl( new Future::Impl( future._impl->_future, name, future._impl->_uuid ))
+    : _impl( future._impl->_followsPromise || future._impl->_name != name
+             ? std::allocate_shared< Future::Impl >( PoolAllocator< Future::Impl >(),
+                                                     future._impl->_state,
+                                                     name,
+                                                     false )
+             : future._impl )
 {}
 
 void Future::wait() const
@@ -228,14 +506,37 @@ bool Future::isReady() const
     return _impl->isReady();
 }
 
+bool Future::isReleased() const
+{
+    return _impl->_state->_released;
+}
+
+void Future::onReady( const ReadyCallback& callback ) const
+{
+    _impl->onReady( callback );
+}
+
+Future Future::then( const ContinuationFunc& callback, Executor& executor ) const
+{
+    const ExecutablePtr continuation =
+            std::make_shared< ContinuationExecutable >( *this, callback );
+    executor.schedule( continuation );
+    return continuation->getPostconditions().front();
+}
+
 bool Future::operator==( const Future& future ) const
 {
-    return _impl->_uuid == future._impl->_uuid;
+    return getId() == future.getId();
 }
 
-std::string Future::getId() const
+uint64_t Future::getId() const
 {
-    return boost::to_string( _impl->_uuid );
+    return _impl->_state->_id;
+}
+
+PortDataPtr Future::getPortData() const
+{
+    return _impl->_state->get();
 }
 
 PortDataPtr Future::_getPtr( const std::type_index& dataType ) const
@@ -243,17 +544,109 @@ PortDataPtr Future::_getPtr( const std::type_index& dataType ) const
     return _impl->get( dataType );
 }
 
+bool operator<( const Future& future1, const Future& future2 )
+{
+    return future1.getId() < future2.getId();
+}
+
+std::ostream& operator<<( std::ostream& os, const Future& future )
+{
+    return os << future.getName() << "#" << future.getId();
+}
+
 void waitForAny( const Futures& futures )
 {
     if( futures.empty( ))
         return;
 
-    PortDataFutures boostFutures;
-    boostFutures.reserve( futures.size( ));
     for( const auto& future: futures )
-        boostFutures.push_back( future._impl->_future );
+    {
+        if( future.isReady( ))
+            return;
+    }
 
-    boost::wait_for_any( boostFutures.begin(), boostFutures.end( ));
+    // The callbacks are removed from the pending futures on return, so the
+    // repeated waits on a future do not accumulate them. A callback taken by
+    // a concurrent set may still be called after the function returns, so
+    // the waiter is shared with them.
+    struct AnyWaiter
+    {
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool ready = false;
+    };
+
+    const std::shared_ptr< AnyWaiter > waiter = std::make_shared< AnyWaiter >();
+    std::vector< FutureStatePtr > states;
+    states.reserve( futures.size( ));
+    for( const auto& future: futures )
+    {
+        states.push_back( future._impl->_state );
+        states.back()->onReady( [ waiter ]
+        {
+            std::lock_guard< std::mutex > lock( waiter->mutex );
+            waiter->ready = true;
+            waiter->condition.notify_one();
+        }, waiter.get( ));
+    }
+
+    {
+        std::unique_lock< std::mutex > lock( waiter->mutex );
+        waiter->condition.wait( lock, [ &waiter ]{ return waiter->ready; });
+    }
+
+    for( const auto& state: states )
+        state->removeCallbacks( waiter.get( ));
+}
+
+void forEachReady( const Futures& futures,
+                   const std::function< void( const Future& ) >& func )
+{
+    std::vector< const Future* > pending;
+    for( const auto& future: futures )
+    {
+        if( future.isReady( ))
+            func( future );
+        else
+            pending.push_back( &future );
+    }
+
+    if( pending.empty( ))
+        return;
+
+    // The callbacks may be called after the function returns ( i.e. when func
+    // throws ), so the queue is shared with them. The queued futures are only
+    // accessed while the function runs.
+    struct ReadyQueue
+    {
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque< const Future* > futures;
+    };
+
+    const std::shared_ptr< ReadyQueue > queue = std::make_shared< ReadyQueue >();
+    for( const Future* future: pending )
+    {
+        future->onReady( [ queue, future ]
+        {
+            std::lock_guard< std::mutex > lock( queue->mutex );
+            queue->futures.push_back( future );
+            queue->condition.notify_one();
+        });
+    }
+
+    for( size_t i = 0; i < pending.size(); ++i )
+    {
+        const Future* future;
+        {
+            std::unique_lock< std::mutex > lock( queue->mutex );
+            queue->condition.wait( lock, [ &queue ]
+                                   { return !queue->futures.empty(); });
+            future = queue->futures.front();
+            queue->futures.pop_front();
+        }
+        func( *future );
+    }
 }
 
 }
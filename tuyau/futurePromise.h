@@ -25,6 +25,8 @@
 #include "portData.h"
 #include "types.h"
 
+#include <iosfwd>
+
 namespace tuyau
 {
 
@@ -61,9 +63,60 @@ public:
     template< class T >
     void set( const T& value )
     {
-        _set( std::make_shared< PortDataT< T >>( value ));
+        _set( makePortData< T >( value ));
+    }
+
+    /**
+     * Sets the port with the value, without copying it.
+     * @param value to be moved
+     * @throw std::runtime_error when the port data is not exact
+     * type T or there is no such port name.
+     */
+    template< class T >
+    void set( T&& value )
+    {
+        typedef typename std::decay< T >::type DataT;
+        _set( makePortData< DataT >( std::forward< T >( value )));
     }
 
+    /**
+     * Sets the port with a value constructed in place.
+     * @param args are the arguments for the construction of T
+     * @throw std::runtime_error when the port data is not exact
+     * type T or there is no such port name.
+     */
+    template< class T, class... Args >
+    void emplace( Args&&... args )
+    {
+        _set( makePortData< T >( InPlace(), std::forward< Args >( args )... ));
+    }
+
+    /**
+     * Sets the port with a shared value, without copying it. The value should
+     * not be modified afterwards.
+     * @param value to be shared
+     * @throw std::runtime_error when the port data is not exact
+     * type T, value is empty or there is no such port name.
+     */
+    template< class T >
+    void adopt( const std::shared_ptr< T >& value )
+    {
+        typedef typename std::remove_const< T >::type DataT;
+        if( !value )
+            throw std::runtime_error( "Empty value can not be adopted" );
+
+        _set( makePortData< DataT >( std::shared_ptr< const DataT >( value )));
+    }
+
+    /**
+     * Sets the port with the type erased data, i.e. to publish the data of
+     * another future without copying it.
+     * @param data to be set, empty data flushes the promise
+     * @throw std::runtime_error when the port data type does not match or
+     * the promise is already set.
+     */
+    TUYAU_API void setPortData( const PortDataPtr& data );
+
     /**
      * Sets the promise with empty data if it is not set already
      */
@@ -86,10 +139,31 @@ public:
      */
     TUYAU_API void reset();
 
+    /**
+     * Releases the data of a set promise, when none of the consumers needs it
+     * any more, to free its memory before the promise is reset. The futures
+     * stay ready, Future::isReleased() returns true and Future::get() throws.
+     * The data should not be accessed concurrently through the futures.
+     * Has no effect if the promise is not set.
+     */
+    TUYAU_API void release();
+
+    /**
+     * Registers a callback which is called with the future each time the
+     * promise is set or flushed, until the promise is destroyed. Unlike
+     * Future::onReady(), the callback stays registered when the promise is
+     * reset. The callback is executed in the thread which sets the promise,
+     * after the futures are ready.
+     * @param callback is the function to be called.
+     */
+    TUYAU_API void onSet( const ContinuationFunc& callback );
+
 private:
 
     friend class Future;
 
+    void _notify();
+
     void _set( PortDataPtr data );
 
     struct Impl;
@@ -133,6 +207,12 @@ public:
     template< class T >
     const T& get() const { return _get<T>(); }
 
+    /**
+     * Gets the type erased data. Blocks until data is available.
+     * @return the data, empty if the promise is flushed without data.
+     */
+    PortDataPtr getPortData() const;
+
     /**
      * Waits until the data is ready.
      */
@@ -143,6 +223,33 @@ public:
      */
     bool isReady() const;
 
+    /**
+     * @return true if the data is released by the promise ( see
+     * Promise::release() ).
+     */
+    bool isReleased() const;
+
+    /**
+     * Registers a callback which is called once when the future becomes ready.
+     * The callback is executed in the thread which sets ( or flushes, resets )
+     * the promise. If the future is already ready, the callback is executed
+     * immediately in the calling thread.
+     * @param callback is the function to be called.
+     */
+    void onReady( const ReadyCallback& callback ) const;
+
+    /**
+     * Schedules a continuation on the executor, which executes the callback
+     * with the future when it is ready. Unlike onReady(), the callback is not
+     * executed by the thread setting the promise, so it can run long tasks
+     * and continuations can be chained without blocking a thread.
+     * @param callback is the function to be called with the future.
+     * @param executor executes the callback. It should outlive the future.
+     * @return the future which is ready ( without data ) when the callback
+     * is executed, i.e. to chain further continuations.
+     */
+    TUYAU_API Future then( const ContinuationFunc& callback, Executor& executor ) const;
+
     /**
      * @param future is the future to be checked with
      * @return true if both futures are belonging to same promise
@@ -155,8 +262,12 @@ public:
      */
     bool operator!=( const Future& future ) const { return !(*this == future); }
 
-    /** @return the unique identifier for the future */
-    std::string getId() const;
+    /**
+     * @return the unique identifier of the promise value the future belongs
+     * to. The identifiers are increasing in the order of the creation of the
+     * values and a reset promise gets a new identifier.
+     */
+    uint64_t getId() const;
 
     /**
      * Promise based construction is needed when reset() on the promise
@@ -170,9 +281,7 @@ public:
 private:
 
     friend class Promise;
-
-    friend void waitForAny( const Futures& future );
-    friend bool operator<( const Future& future1, const Future& future2 );
+    friend void waitForAny( const Futures& futures );
 
     template< class T >
     const T& _get() const
@@ -189,6 +298,17 @@ private:
     std::shared_ptr<Impl> _impl;
 };
 
+/**
+ * Orders the futures by their identifiers.
+ * @return true if future1 belongs to an earlier promise value than future2
+ */
+bool operator<( const Future& future1, const Future& future2 );
+
+/**
+ * Writes the name and the identifier of the future, for debugging.
+ */
+std::ostream& operator<<( std::ostream& os, const Future& future );
+
 /**
  * Waits for any futures to be ready. If there are already ready futures, the function returns
  * immediately.
@@ -196,6 +316,29 @@ private:
  */
 void waitForAny( const Futures& futures );
 
+/**
+ * Calls the function for each future in the order the futures become ready.
+ * The function is called in the calling thread and the call returns after all
+ * the futures are processed.
+ * @param futures that are processed
+ * @param func is called with each ready future
+ */
+void forEachReady( const Futures& futures,
+                   const std::function< void( const Future& ) >& func );
+
+}
+
+namespace std
+{
+/** Hashes the futures by their identifiers */
+template<>
+struct hash< tuyau::Future >
+{
+    size_t operator()( const tuyau::Future& future ) const
+    {
+        return std::hash< uint64_t >()( future.getId( ));
+    }
+};
 }
 
 #endif // _Promise_h_
@@ -21,9 +21,16 @@
 #include "outputPort.h"
 #include "futurePromise.h"
 
+#include <atomic>
+
 namespace tuyau
 {
 
+namespace
+{
+std::atomic< uint64_t > connectionVersion( 0 );
+}
+
 struct InputPort::Impl
 {
     Impl( const DataInfo& info )
@@ -55,6 +62,7 @@ struct InputPort::Impl
             throw std::runtime_error( "Data types does not match between ports");
 
         _futures.emplace_back( port.getPromise( ));
+        ++connectionVersion;
     }
 
     bool disconnect( const OutputPort& port )
@@ -64,7 +72,10 @@ struct InputPort::Impl
                                     port.getPromise().getFuture( ));
 
         if( it != _futures.end( ))
+        {
             _futures.erase( it );
+            ++connectionVersion;
+        }
 
         return false;
     }
@@ -95,6 +106,11 @@ bool InputPort::disconnect( const OutputPort& port )
     return _impl->disconnect( port );
 }
 
+uint64_t InputPort::getConnectionVersion()
+{
+    return connectionVersion;
+}
+
 std::string InputPort::getName() const
 {
     return _impl->getName();
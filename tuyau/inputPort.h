@@ -73,6 +73,13 @@ public:
      */
     TUYAU_API bool disconnect( const OutputPort& port );
 
+    /**
+     * @return the process wide count of the connection changes of the input
+     * ports. The users caching the graph topology ( i.e. Pipeline ) compare it
+     * to detect the changes.
+     */
+    TUYAU_API static uint64_t getConnectionVersion();
+
 private:
 
     struct Impl;
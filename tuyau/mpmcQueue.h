@@ -0,0 +1,143 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _mpmcQueue_h_
+#define _mpmcQueue_h_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace tuyau
+{
+/**
+ * A lock-free, bounded, multi-producer multi-consumer FIFO queue.
+ *
+ * Alternative to MTQueue, with the same push/pop/tryPop/timedPop interface.
+ * The elements are kept in a ring buffer of S cells, each cell carrying a
+ * sequence number which orders the producers and the consumers without a lock.
+ *
+ * Blocking calls spin for a short while and then park on a condition
+ * variable. The condition variable is only notified when there is a parked
+ * thread, and a push wakes at most one parked consumer ( a pop at most one
+ * parked producer ).
+ *
+ * S has to be a power of two. T has to be default constructible and
+ * assignable. The popped cells are reset to T().
+ */
+template <typename T, size_t S = 1024>
+class MPMCQueue
+{
+    static_assert(S >= 2 && (S & (S - 1)) == 0,
+                  "MPMCQueue capacity must be a power of two");
+
+public:
+    typedef T value_type;
+
+    /** Construct a new queue. */
+    MPMCQueue();
+
+    /** Destruct this queue. */
+    ~MPMCQueue() {}
+    /** @return true if the queue is empty, false otherwise. */
+    bool isEmpty() const { return getSize() == 0; }
+    /** @return the approximate number of items currently in the queue. */
+    size_t getSize() const;
+
+    /** @return the maximum size of the queue. */
+    size_t getMaxSize() const { return S; }
+    /** Reset (empty) the queue. */
+    void clear();
+
+    /** Retrieve and pop the front element from the queue, may block. */
+    T pop();
+
+    /**
+     * Retrieve and pop the front element from the queue.
+     *
+     * @param timeout the timeout in milliseconds
+     * @param element the element returned
+     * @return true if an element was popped
+     */
+    bool timedPop(const unsigned timeout, T& element);
+
+    /**
+     * Retrieve and pop the front element from the queue if it is not empty.
+     *
+     * @param result the front value or unmodified.
+     * @return true if an element was placed in result, false if the queue
+     *         is empty.
+     */
+    bool tryPop(T& result);
+
+    /** Push a new element to the back of the queue, blocks if it is full. */
+    void push(const T& element);
+
+    /**
+     * Push a new element to the back of the queue if it is not full.
+     *
+     * @return true if the element was pushed, false if the queue is full.
+     */
+    bool tryPush(const T& element);
+
+    /** @name STL compatibility. */
+    //@{
+    void push_back(const T& element) { push(element); }
+    bool empty() const { return isEmpty(); }
+    //@}
+
+private:
+    MPMCQueue(const MPMCQueue<T, S>&) = delete;
+    MPMCQueue<T, S>& operator=(const MPMCQueue<T, S>&) = delete;
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    enum
+    {
+        SPIN_COUNT = 128,
+        CACHE_LINE = 64
+    };
+
+    void _notify(std::atomic<size_t>& sleepers,
+                 std::condition_variable& condition);
+
+    std::vector<Cell> _cells;
+    char _pad0[CACHE_LINE];
+    std::atomic<size_t> _pushPos;
+    char _pad1[CACHE_LINE];
+    std::atomic<size_t> _popPos;
+    char _pad2[CACHE_LINE];
+
+    std::mutex _parkMutex;
+    std::condition_variable _notEmpty;
+    std::condition_variable _notFull;
+    std::atomic<size_t> _sleepingConsumers;
+    std::atomic<size_t> _sleepingProducers;
+};
+}
+
+#include "mpmcQueue.ipp" // template implementation
+
+#endif // _mpmcQueue_h_
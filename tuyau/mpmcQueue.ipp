@@ -0,0 +1,188 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <cstdint>
+#include <thread>
+
+namespace tuyau
+{
+template <typename T, size_t S>
+MPMCQueue<T, S>::MPMCQueue()
+    : _cells(S)
+    , _pushPos(0)
+    , _popPos(0)
+    , _sleepingConsumers(0)
+    , _sleepingProducers(0)
+{
+    for (size_t i = 0; i < S; ++i)
+        _cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template <typename T, size_t S>
+size_t MPMCQueue<T, S>::getSize() const
+{
+    const size_t popPos = _popPos.load();
+    const size_t pushPos = _pushPos.load();
+    return pushPos > popPos ? pushPos - popPos : 0;
+}
+
+template <typename T, size_t S>
+void MPMCQueue<T, S>::clear()
+{
+    T element;
+    while (tryPop(element))
+    {
+    }
+}
+
+template <typename T, size_t S>
+bool MPMCQueue<T, S>::tryPush(const T& element)
+{
+    size_t pos = _pushPos.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true)
+    {
+        cell = &_cells[pos & (S - 1)];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const intptr_t diff = intptr_t(sequence) - intptr_t(pos);
+        if (diff == 0)
+        {
+            if (_pushPos.compare_exchange_weak(pos, pos + 1))
+                break;
+        }
+        else if (diff < 0)
+            return false; // full
+        else
+            pos = _pushPos.load(std::memory_order_relaxed);
+    }
+
+    cell->data = element;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    _notify(_sleepingConsumers, _notEmpty);
+    return true;
+}
+
+template <typename T, size_t S>
+bool MPMCQueue<T, S>::tryPop(T& result)
+{
+    size_t pos = _popPos.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true)
+    {
+        cell = &_cells[pos & (S - 1)];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const intptr_t diff = intptr_t(sequence) - intptr_t(pos + 1);
+        if (diff == 0)
+        {
+            if (_popPos.compare_exchange_weak(pos, pos + 1))
+                break;
+        }
+        else if (diff < 0)
+            return false; // empty
+        else
+            pos = _popPos.load(std::memory_order_relaxed);
+    }
+
+    result = std::move(cell->data);
+    cell->data = T();
+    cell->sequence.store(pos + S, std::memory_order_release);
+    _notify(_sleepingProducers, _notFull);
+    return true;
+}
+
+template <typename T, size_t S>
+void MPMCQueue<T, S>::_notify(std::atomic<size_t>& sleepers,
+                              std::condition_variable& condition)
+{
+    // Pairs with the increment of the sleepers before the parked thread checks
+    // the queue state, so either the sleeper or the notifier sees the other.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers.load() == 0)
+        return;
+
+    std::unique_lock<std::mutex> lock(_parkMutex);
+    condition.notify_one();
+}
+
+template <typename T, size_t S>
+T MPMCQueue<T, S>::pop()
+{
+    T element;
+    while (true)
+    {
+        for (size_t i = 0; i < SPIN_COUNT; ++i)
+        {
+            if (tryPop(element))
+                return element;
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock(_parkMutex);
+        ++_sleepingConsumers;
+        _notEmpty.wait(lock, [&] { return !isEmpty(); });
+        --_sleepingConsumers;
+    }
+}
+
+template <typename T, size_t S>
+bool MPMCQueue<T, S>::timedPop(const unsigned timeout, T& element)
+{
+    const auto end =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    while (true)
+    {
+        for (size_t i = 0; i < SPIN_COUNT; ++i)
+        {
+            if (tryPop(element))
+                return true;
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock(_parkMutex);
+        ++_sleepingConsumers;
+        const bool ready =
+            _notEmpty.wait_until(lock, end, [&] { return !isEmpty(); });
+        --_sleepingConsumers;
+        if (!ready)
+        {
+            lock.unlock();
+            return tryPop(element);
+        }
+    }
+}
+
+template <typename T, size_t S>
+void MPMCQueue<T, S>::push(const T& element)
+{
+    while (true)
+    {
+        for (size_t i = 0; i < SPIN_COUNT; ++i)
+        {
+            if (tryPush(element))
+                return;
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock(_parkMutex);
+        ++_sleepingProducers;
+        _notFull.wait(lock, [&] { return getSize() < S; });
+        --_sleepingProducers;
+    }
+}
+}
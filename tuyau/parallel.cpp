@@ -0,0 +1,146 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "parallel.h"
+#include "futurePromise.h"
+#include "workers.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+
+namespace tuyau
+{
+
+namespace
+{
+
+// The chunks per thread, which balance the load of uneven iterations
+const size_t chunksPerThread = 4;
+
+/**
+ * The chunks of a parallel loop, which are claimed by the calling thread and
+ * the helper tasks on the workers. The helpers may start after the loop is
+ * finished, so the state is shared with them.
+ */
+struct ParallelLoop
+{
+    ParallelLoop( const size_t begin_, const size_t end_, const size_t nChunks_,
+                  const RangeFunc& func_ )
+        : begin( begin_ )
+        , end( end_ )
+        , nChunks( nChunks_ )
+        , func( func_ )
+        , next( 0 )
+        , remaining( nChunks_ )
+        , done( DataInfo( "ParallelFor", getType< void >( )))
+    {}
+
+    /** Executes the chunks until all of them are claimed */
+    void execute()
+    {
+        size_t chunk;
+        while(( chunk = next++ ) < nChunks )
+        {
+            try
+            {
+                func( getChunkBegin( begin, end, nChunks, chunk ),
+                      getChunkBegin( begin, end, nChunks, chunk + 1 ));
+            }
+            catch( ... )
+            {
+                std::lock_guard< std::mutex > lock( mutex );
+                if( !error )
+                    error = std::current_exception();
+            }
+
+            // The function is not accessed after the last chunk, as the
+            // caller returns
+            if( --remaining == 0 )
+                done.flush();
+        }
+    }
+
+    const size_t begin;
+    const size_t end;
+    const size_t nChunks;
+    const RangeFunc& func;
+    std::atomic< size_t > next;
+    std::atomic< size_t > remaining;
+    Promise done;
+    std::mutex mutex;
+    std::exception_ptr error;
+};
+
+}
+
+size_t getChunkCount( const size_t size, const size_t grainSize )
+{
+    const Workers* workers = Workers::getCurrent();
+    if( size == 0 )
+        return 0;
+
+    if( !workers || workers->getSize() == 1 )
+        return 1;
+
+    const size_t grain = grainSize > 0
+            ? grainSize
+            : std::max( size / ( chunksPerThread * workers->getSize( )), size_t( 1 ));
+    return size / grain + ( size % grain > 0 ? 1 : 0 );
+}
+
+size_t getChunkBegin( const size_t begin, const size_t end, const size_t nChunks,
+                      const size_t chunk )
+{
+    // The first chunks take the remainder, without overflowing size * chunk
+    const size_t size = end - begin;
+    return begin + chunk * ( size / nChunks ) + std::min( chunk, size % nChunks );
+}
+
+void parallelFor( const size_t begin, const size_t end, const RangeFunc& func,
+                  const size_t grainSize )
+{
+    if( end <= begin )
+        return;
+
+    const size_t nChunks = getChunkCount( end - begin, grainSize );
+
+    if( nChunks == 1 )
+    {
+        func( begin, end );
+        return;
+    }
+
+    Workers& workers = *Workers::getCurrent();
+    const std::shared_ptr< ParallelLoop > loop =
+            std::make_shared< ParallelLoop >( begin, end, nChunks, func );
+    const size_t nHelpers = std::min( nChunks, workers.getSize( )) - 1;
+    for( size_t i = 0; i < nHelpers; ++i )
+        workers.submit( [ loop ]{ loop->execute(); });
+
+    loop->execute();
+    Workers::await( loop->done.getFuture( ));
+
+    if( loop->error )
+        std::rethrow_exception( loop->error );
+}
+
+}
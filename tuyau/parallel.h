@@ -0,0 +1,114 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef _Parallel_h_
+#define _Parallel_h_
+
+#include <tuyau/api.h>
+#include "types.h"
+
+#include <vector>
+
+namespace tuyau
+{
+
+/**
+ * @param size is the number of iterations
+ * @param grainSize is the minimum number of iterations of a chunk, 0 for a
+ * few chunks per thread
+ * @return the number of chunks of the iterations for the workers of the
+ * current thread ( see Workers::getCurrent() ), 1 out of the worker threads
+ * and 0 for no iterations
+ */
+TUYAU_API size_t getChunkCount( size_t size, size_t grainSize = 0 );
+
+/**
+ * @param begin is the first iteration
+ * @param end is the iteration after the last one
+ * @param nChunks is the number of chunks of the iterations
+ * @param chunk is the index of the chunk, nChunks for the end of the last one
+ * @return the first iteration of the chunk, the chunks differ by at most one
+ * iteration in size
+ */
+TUYAU_API size_t getChunkBegin( size_t begin, size_t end, size_t nChunks,
+                                size_t chunk );
+
+/**
+ * Executes the iterations in chunks on the workers of the current thread, so
+ * that the filters can parallelize their execution without creating threads.
+ * The calling thread executes chunks, too. When the remaining chunks are
+ * executed by the other threads, the caller is suspended until they are
+ * finished ( see Workers::await() ) and its thread executes other work. Out
+ * of the worker threads, the iterations are executed by the calling thread.
+ * @param begin is the first iteration
+ * @param end is the iteration after the last one, there are no iterations if
+ * it is not after begin
+ * @param func is called with the range of the iterations of each chunk,
+ * concurrently for the chunks
+ * @param grainSize is the minimum number of iterations of a chunk, 0 for a
+ * few chunks per thread
+ * @throw the first exception thrown by func, after all chunks are finished
+ */
+TUYAU_API void parallelFor( size_t begin, size_t end, const RangeFunc& func,
+                            size_t grainSize = 0 );
+
+/**
+ * Reduces the iterations in chunks on the workers of the current thread ( see
+ * parallelFor() ). The results of the chunks are combined in the chunk order,
+ * so the result does not depend on the threads.
+ * @param begin is the first iteration
+ * @param end is the iteration after the last one, there are no iterations if
+ * it is not after begin
+ * @param identity is the result of no iterations
+ * @param reduce returns the result of a range of iterations, T( size_t begin,
+ * size_t end ), it is called concurrently for the chunks
+ * @param combine returns the combination of two results, T( const T&,
+ * const T& )
+ * @param grainSize is the minimum number of iterations of a chunk, 0 for a
+ * few chunks per thread
+ * @return the combined result of the chunks
+ * @throw the first exception thrown by reduce, after all chunks are finished
+ */
+template< class T, class ReduceFunc, class CombineFunc >
+T parallelReduce( const size_t begin, const size_t end, const T& identity,
+                  const ReduceFunc& reduce, const CombineFunc& combine,
+                  const size_t grainSize = 0 )
+{
+    if( end <= begin )
+        return identity;
+
+    const size_t nChunks = getChunkCount( end - begin, grainSize );
+    std::vector< T > results( nChunks, identity );
+    parallelFor( 0, nChunks, [ & ]( const size_t first, const size_t last )
+    {
+        for( size_t chunk = first; chunk < last; ++chunk )
+            results[ chunk ] = reduce( getChunkBegin( begin, end, nChunks, chunk ),
+                                       getChunkBegin( begin, end, nChunks, chunk + 1 ));
+    }, 1 );
+
+    T result = identity;
+    for( const T& chunkResult: results )
+        result = combine( result, chunkResult );
+    return result;
+}
+
+}
+
+#endif // _Parallel_h_
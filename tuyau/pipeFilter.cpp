@@ -25,21 +25,186 @@
 #include "pipeFilter.h"
 #include "futurePromise.h"
 #include "filter.h"
+#include "trace.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
 
 namespace tuyau
 {
 
+namespace
+{
+
+/**
+ * LRU cache of the outputs of a pure filter. The key is the list of the hashes
+ * of the input data and the value is the list of output data ( empty for the
+ * outputs which are not set ) in the port order. As different inputs may have
+ * the same hashes, the entries keep the input data, which is compared on
+ * lookup. An entry is replaced by the outputs of colliding inputs.
+ */
+class OutputCache
+{
+public:
+
+    typedef std::vector< size_t > Key;
+    typedef std::vector< PortDataPtr > Inputs;
+    typedef std::vector< PortDataPtr > Outputs;
+
+    explicit OutputCache( const size_t capacity )
+        : _capacity( capacity )
+        , _stats( CacheStats())
+    {}
+
+    bool find( const Key& key, const Inputs& inputs, Outputs& outputs )
+    {
+        ScopedLock lock( _mutex );
+        const auto it = _entries.find( key );
+        if( it == _entries.end() || !isEqual( it->second.inputs, inputs ))
+        {
+            ++_stats.misses;
+            return false;
+        }
+
+        ++_stats.hits;
+        _order.splice( _order.begin(), _order, it->second.position );
+        outputs = it->second.outputs;
+        return true;
+    }
+
+    void insert( const Key& key, const Inputs& inputs, const Outputs& outputs )
+    {
+        ScopedLock lock( _mutex );
+        const auto it = _entries.find( key );
+        if( it != _entries.end( ))
+        {
+            if( !isEqual( it->second.inputs, inputs ))
+            {
+                it->second.inputs = inputs;
+                it->second.outputs = outputs;
+                _order.splice( _order.begin(), _order, it->second.position );
+            }
+            return;
+        }
+
+        if( _entries.size() == _capacity )
+        {
+            _entries.erase( _order.back( ));
+            _order.pop_back();
+        }
+
+        _order.push_front( key );
+        _entries.insert({ key, { inputs, outputs, _order.begin() }});
+    }
+
+    void bypass()
+    {
+        ScopedLock lock( _mutex );
+        ++_stats.bypasses;
+    }
+
+    CacheStats getStats() const
+    {
+        ScopedLock lock( _mutex );
+        CacheStats stats = _stats;
+        stats.size = _entries.size();
+        return stats;
+    }
+
+private:
+
+    static bool isEqual( const Inputs& lhs, const Inputs& rhs )
+    {
+        if( lhs.size() != rhs.size( ))
+            return false;
+
+        for( size_t i = 0; i < lhs.size(); ++i )
+        {
+            if( lhs[ i ] != rhs[ i ] &&
+                ( !lhs[ i ] || !rhs[ i ] || !lhs[ i ]->isEqual( *rhs[ i ])))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    struct Entry
+    {
+        Inputs inputs;
+        Outputs outputs;
+        std::list< Key >::iterator position;
+    };
+
+    const size_t _capacity;
+    mutable boost::mutex _mutex;
+    std::map< Key, Entry > _entries;
+    std::list< Key > _order; // Most recently used first
+    CacheStats _stats;
+};
+
+typedef std::shared_ptr< OutputCache > OutputCachePtr;
+
+/**
+ * Mutex which can be unlocked by another thread than the one which locked it,
+ * as the execution of a filter may resume on another worker thread after an
+ * await ( see AsyncFilter ).
+ */
+class ExecutionMutex
+{
+public:
+
+    ExecutionMutex()
+        : _locked( false )
+    {}
+
+    void lock()
+    {
+        std::unique_lock< std::mutex > lock( _mutex );
+        _condition.wait( lock, [ this ]{ return !_locked; });
+        _locked = true;
+    }
+
+    void unlock()
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        _locked = false;
+        _condition.notify_one();
+    }
+
+private:
+
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _locked;
+};
+
+typedef std::lock_guard< ExecutionMutex > ExecutionLock;
+
+}
+
 struct PipeFilter::Impl
 {
     typedef std::map< std::string, OutputPort > OutputPortMap;
     typedef std::map< std::string, InputPort > InputPortMap;
 
+    /** Connection from an output port to a pipe filter input port */
+    struct Connection
+    {
+        std::string srcPortName;
+        std::string dstName;
+        std::string dstPortName;
+    };
+
     Impl( PipeFilter& pipeFilter,
           const std::string& name,
-          FilterPtr filter )
+          const std::shared_ptr< const Filter >& filter )
         : _pipeFilter( pipeFilter )
         , _name( name )
-        , _filter( std::move( filter ))
+        , _filter( filter )
+        , _priority( 0 )
     {
         for( const DataInfo& dataInfo: _filter->getInputDataInfos( ))
         {
@@ -54,6 +219,17 @@ struct PipeFilter::Impl
                                 std::forward_as_tuple( dataInfo.first ),
                                 std::forward_as_tuple( dataInfo ));
         }
+
+        // The port maps are fixed, so the maps for the filter execution are
+        // built once. The input futures are renamed with the port names and
+        // updated before the executions, the promises of the output ports
+        // follow the resets.
+        std::vector< const InputPort* > inputPorts;
+        for( const auto& namePort: _inputMap )
+            inputPorts.push_back( &namePort.second );
+
+        _inputFutures.reset( new FutureMap( inputPorts ));
+        _outputPromises.reset( new PromiseMap( getOutputPromises( )));
     }
 
     bool hasInputPort( const std::string& portName ) const
@@ -73,32 +249,111 @@ struct PipeFilter::Impl
 
     void execute()
     {
-        Futures inputFutures;
-        for( const auto& namePort: _inputMap )
+        // The outputs are flushed after the filter sets them, reset() has to
+        // wait until the execution finishes.
+        ExecutionLock lock( _executeMutex );
+        const TraceScope trace( "filter", _name );
+
+        _inputFutures->_update();
+        const FutureMap& futures = *_inputFutures;
+        PromiseMap& promises = *_outputPromises;
+
+        OutputCache::Key key;
+        OutputCache::Inputs inputs;
+        if( _cache && !getCacheKey( key, inputs ))
         {
-            const Futures& futures = namePort.second.getFutures();
-            for( const auto& future: futures )
-                inputFutures.emplace_back( future, namePort.second.getName( ));
+            _cache->bypass();
+            key.clear();
         }
 
-        const FutureMap futures( inputFutures );
-        PromiseMap promises( getOutputPromises( ));
+        if( !key.empty( ))
+        {
+            OutputCache::Outputs outputs;
+            if( _cache->find( key, inputs, outputs ))
+            {
+                if( Trace::isEnabled( ))
+                    Trace::instant( "cache", _name );
+
+                for( size_t i = 0; i < outputs.size(); ++i )
+                {
+                    if( outputs[ i ] )
+                        promises.getPromise( PortHandle( i )).setPortData( outputs[ i ]);
+                }
+                setExecuted();
+                promises.flush();
+                return;
+            }
+        }
 
+        // The execution is recorded before the outputs are set, which wakes
+        // up the waiting threads, and is discarded if it fails
+        setExecuted();
         try
         {
             _filter->execute( futures, promises );
             promises.flush();
         }
-        catch( const std::runtime_error& err )
+        catch( ... )
         {
+            _executedIds.clear();
             promises.flush();
-            throw err;
+            throw;
+        }
+
+        if( !key.empty( ))
+        {
+            OutputCache::Outputs outputs;
+            for( size_t i = 0; i < _outputMap.size(); ++i )
+                outputs.push_back( promises.getPromise( PortHandle( i )).getFuture().getPortData( ));
+            _cache->insert( key, inputs, outputs );
         }
-        catch( const std::logic_error& err )
+    }
+
+    /**
+     * Waits for the inputs and hashes them into the key.
+     * @param key is filled with the hashes of the inputs
+     * @param inputs is filled with the input data, which is compared with the
+     * inputs of the cached entry
+     * @return false if an input is not hashable
+     */
+    bool getCacheKey( OutputCache::Key& key, OutputCache::Inputs& inputs ) const
+    {
+        key.push_back( _inputMap.size( ));
+        for( const auto& namePort: _inputMap )
         {
-            promises.flush();
-            throw err;
+            const Futures& futures = namePort.second.getFutures();
+            key.push_back( futures.size( ));
+            for( const auto& future: futures )
+            {
+                const PortDataPtr& data = future.getPortData();
+                size_t hash = 0;
+                if( data && !data->getHash( hash ))
+                    return false;
+
+                key.push_back( data ? 1 : 0 );
+                key.push_back( hash );
+                inputs.push_back( data );
+            }
         }
+        return true;
+    }
+
+    void setCacheSize( const size_t capacity )
+    {
+        if( capacity > 0 && !_filter->isPure( ))
+            throw std::logic_error( std::string( "Filter is not pure: ") + _name );
+
+        ExecutionLock lock( _executeMutex );
+        if( capacity == 0 )
+            _cache.reset();
+        else
+            _cache = std::make_shared< OutputCache >( capacity );
+    }
+
+    CacheStats getCacheStats()
+    {
+        ExecutionLock lock( _executeMutex );
+        return _cache ? _cache->getStats() : CacheStats();
     }
 
     Promise getInputPromise( const std::string& portName )
@@ -129,6 +384,68 @@ struct PipeFilter::Impl
         return promises;
     }
 
+    void getIds( std::vector< uint64_t >& ids ) const
+    {
+        size_t inputCount = 0;
+        for( const auto& namePort: _inputMap )
+            inputCount += namePort.second.getFutures().size();
+
+        ids.reserve( ids.size() + 1 + inputCount + _outputMap.size( ));
+        ids.push_back( inputCount );
+        for( const auto& namePort: _inputMap )
+        {
+            for( const auto& future: namePort.second.getFutures( ))
+                ids.push_back( future.getId( ));
+        }
+
+        for( const auto& namePort: _outputMap )
+            ids.push_back( Future( namePort.second.getPromise( )).getId( ));
+    }
+
+    /**
+     * Records the identifiers of an execution, so the executions dropped
+     * without running are not recorded. The record keeps its memory.
+     */
+    void setExecuted()
+    {
+        _executedIds.clear();
+        getIds( _executedIds );
+    }
+
+    bool isExecuted()
+    {
+        ExecutionLock lock( _executeMutex );
+        if( _executedIds.empty( ))
+            return false;
+
+        _ids.clear();
+        getIds( _ids );
+        return _ids == _executedIds;
+    }
+
+    bool isReady() const
+    {
+        for( const auto& namePort: _inputMap )
+        {
+            for( const auto& future: namePort.second.getFutures( ))
+            {
+                if( !future.isReady( ))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    bool isReleased() const
+    {
+        for( const auto& namePort: _outputMap )
+        {
+            if( Future( namePort.second.getPromise( )).isReleased( ))
+                return true;
+        }
+        return false;
+    }
+
     Futures getPostconditions() const
     {
         Futures futures;
@@ -169,32 +486,140 @@ struct PipeFilter::Impl
 
         _outputMap.find( srcPortName )->second.connect(
                     dstImpl._inputMap.find( dstPortName )->second );
+        _connections.push_back({ srcPortName, dstImpl._name, dstPortName });
+    }
+
+    void connectReplicas( PipeFilterMap& replicas ) const
+    {
+        PipeFilter& src = replicas.find( _name )->second;
+        for( const Connection& connection: _connections )
+        {
+            const auto it = replicas.find( connection.dstName );
+            if( it == replicas.end( ))
+                throw std::logic_error( std::string( "Connected filter is not replicated: ")
+                                        + connection.dstName );
+
+            src.connect( connection.srcPortName, it->second, connection.dstPortName );
+        }
     }
 
     void reset()
     {
+        ExecutionLock lock( _executeMutex );
+
+        // The manually set ports stay connected, so that the executables which
+        // are scheduled before the values are set again wait for them.
         for( auto& namePort: _manuallySetPortsMap )
-            _inputMap.find( namePort.first )->second.disconnect( namePort.second );
+            namePort.second.reset();
 
-        _manuallySetPortsMap.clear();
         for( auto& namePort: _outputMap )
             namePort.second.reset();
+        _executedIds.clear();
+    }
+
+    void resetOutputs()
+    {
+        // The outputs, which are not set, keep their futures, which may be
+        // waited on already
+        ExecutionLock lock( _executeMutex );
+        for( auto& namePort: _outputMap )
+        {
+            if( Future( namePort.second.getPromise( )).isReady( ))
+                namePort.second.reset();
+        }
+        _executedIds.clear();
+    }
 
+    void flushInputs()
+    {
+        for( auto& namePort: _manuallySetPortsMap )
+            namePort.second.getPromise().flush();
+    }
+
+    void flushOutputs()
+    {
+        ExecutionLock lock( _executeMutex );
+        for( auto& namePort: _outputMap )
+            namePort.second.getPromise().flush();
     }
 
     PipeFilter& _pipeFilter;
     const std::string _name;
-    const FilterPtr _filter;
+    const std::shared_ptr< const Filter > _filter;
     InputPortMap _inputMap;
     OutputPortMap _outputMap;
     OutputPortMap _manuallySetPortsMap;
+    std::vector< Connection > _connections;
+    OutputCachePtr _cache;
+    std::vector< uint64_t > _executedIds;
+    std::vector< uint64_t > _ids; // Scratch for the comparison of executions
+    std::atomic< int > _priority;
+    ExecutionMutex _executeMutex;
+    std::unique_ptr< FutureMap > _inputFutures;
+    std::unique_ptr< PromiseMap > _outputPromises;
 };
 
 PipeFilter::PipeFilter( const std::string& name,
                         FilterPtr&& filter )
-    : _impl( new Impl( *this, name, std::move( filter )))
+    : _impl( new Impl( *this, name, std::shared_ptr< const Filter >( std::move( filter ))))
 {}
 
+PipeFilter::PipeFilter( const std::string& name,
+                        const std::shared_ptr< const Filter >& filter )
+    : _impl( new Impl( *this, name, filter ))
+{}
+
+PipeFilter PipeFilter::_replicate() const
+{
+    PipeFilter replica( _impl->_name, _impl->_filter );
+    replica._impl->_cache = _impl->_cache;
+    replica._impl->_priority = _impl->_priority.load();
+    for( const auto& namePort: _impl->_manuallySetPortsMap )
+        replica._impl->getInputPromise( namePort.first );
+
+    return replica;
+}
+
+void PipeFilter::_connectReplicas( PipeFilterMap& replicas ) const
+{
+    _impl->connectReplicas( replicas );
+}
+
+void PipeFilter::_resetOutputs()
+{
+    _impl->resetOutputs();
+}
+
+void PipeFilter::_flushInputs()
+{
+    _impl->flushInputs();
+}
+
+void PipeFilter::_flushOutputs()
+{
+    _impl->flushOutputs();
+}
+
+Promises PipeFilter::_getOutputPromises() const
+{
+    return _impl->getOutputPromises();
+}
+
+bool PipeFilter::_isExecuted() const
+{
+    return _impl->isExecuted();
+}
+
+bool PipeFilter::_isReady() const
+{
+    return _impl->isReady();
+}
+
+bool PipeFilter::_isReleased() const
+{
+    return _impl->isReleased();
+}
+
 ExecutablePtr PipeFilter::clone() const
 {
     return ExecutablePtr( new PipeFilter( *this ));
@@ -208,11 +633,36 @@ std::string PipeFilter::getName() const
     return _impl->_name;
 }
 
+size_t PipeFilter::getEstimatedOutputSize() const
+{
+    return _impl->_filter->getEstimatedOutputSize();
+}
+
+void PipeFilter::setPriority( const int priority )
+{
+    _impl->_priority = priority;
+}
+
+int PipeFilter::getPriority() const
+{
+    return _impl->_priority;
+}
+
 Promise PipeFilter::getPromise( const std::string& portName )
 {
     return _impl->getInputPromise( portName );
 }
 
+void PipeFilter::setCacheSize( const size_t capacity )
+{
+    _impl->setCacheSize( capacity );
+}
+
+CacheStats PipeFilter::getCacheStats() const
+{
+    return _impl->getCacheStats();
+}
+
 void PipeFilter::execute()
 {
     _impl->execute();
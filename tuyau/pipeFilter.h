@@ -27,6 +27,17 @@
 namespace tuyau
 {
 
+/**
+ * The counters of the output cache of a pipe filter.
+ */
+struct CacheStats
+{
+    size_t hits;     //!< Executions which published the cached outputs
+    size_t misses;   //!< Executions which executed the filter
+    size_t bypasses; //!< Executions with inputs which are not hashable
+    size_t size;     //!< Number of cached outputs
+};
+
 /**
  * Responsible for execution of the Filter objects by constructing
  * the communication layer ( output ports, input ports ) around the filter.
@@ -42,7 +53,24 @@ public:
     /**
      * @return the unique name of the filter.
      */
-    TUYAU_API std::string getName() const;
+    TUYAU_API std::string getName() const final;
+
+    /**
+     * @copydoc Filter::getEstimatedOutputSize
+     */
+    TUYAU_API size_t getEstimatedOutputSize() const final;
+
+    /**
+     * Sets the priority of the filter for the executors with a PriorityPolicy.
+     * The replicas of the pipe filter have the same priority.
+     * @param priority of the filter, 0 by default
+     */
+    TUYAU_API void setPriority( int priority );
+
+    /**
+     * @copydoc Executable::getPriority
+     */
+    TUYAU_API int getPriority() const final;
 
     /**
      * Connects to given pipe filter with the given port names. Both filters
@@ -65,6 +93,27 @@ public:
      */
     TUYAU_API Promise getPromise( const std::string& portName );
 
+    /**
+     * Enables the caching of the outputs of a pure filter ( see
+     * Filter::isPure() ). The outputs are cached in a LRU cache keyed by the
+     * hashes of the input data ( see DataHash ), so that the executions with
+     * the same inputs publish the cached outputs without executing the filter.
+     * The cache keeps the input data of the entries, which is compared with
+     * the inputs on lookup, so the inputs with colliding hashes do not share
+     * the outputs. The replicas of the pipe filter share the cache.
+     * @param capacity is the maximum number of cached outputs, 0 disables the
+     * cache.
+     * @throw std::logic_error if the filter is not pure
+     */
+    TUYAU_API void setCacheSize( size_t capacity );
+
+    /**
+     * Waits for a running execution of the pipe filter, which may change the
+     * cache.
+     * @return the counters of the output cache
+     */
+    TUYAU_API CacheStats getCacheStats() const;
+
     /**
      * @copydoc Executable::execute
      */
@@ -81,6 +130,8 @@ public:
     TUYAU_API Futures getPreconditions() const final;
 
     /**
+     * Resets the output ports and the manually set input ports. The promises
+     * of the manually set ports ( see getPromise() ) have to be set again.
      * @copydoc Executable::reset
      */
     TUYAU_API void reset() final;
@@ -97,6 +148,58 @@ protected:
 
 private:
 
+    friend class Pipeline;
+    friend class PipelineStream;
+
+    PipeFilter( const std::string& name,
+                const std::shared_ptr< const Filter >& filter );
+
+    /**
+     * @return a pipe filter with the same name and the same filter ( filters
+     * are immutable ), which has its own ports. The manually set input ports
+     * are created, the connections are not replicated.
+     */
+    PipeFilter _replicate() const;
+
+    /**
+     * Replicates the connections of the filter between the replicas.
+     * @param replicas are the replicas of the filters with their names
+     * @throw std::logic_error if a connected filter is not in the replicas
+     */
+    void _connectReplicas( PipeFilterMap& replicas ) const;
+
+    /**
+     * Resets the set output ports only, the manually set input ports keep
+     * their values ( i.e. for the incremental execution of a pipeline ).
+     */
+    void _resetOutputs();
+
+    /**
+     * Flushes the manually set input ports, which are not set yet, so that
+     * the execution is not blocked by them ( see PipelineStream::cancel() ).
+     */
+    void _flushInputs();
+
+    /** Flushes the output ports, which are not set yet, without execution */
+    void _flushOutputs();
+
+    /** @return the promises of the output ports in the port order */
+    Promises _getOutputPromises() const;
+
+    /**
+     * @return true if the last execution succeeded with the current inputs
+     * and outputs, which are identified without copying the futures: the
+     * number of the input futures, the identifiers of the input futures and
+     * the identifiers of the outputs ( see Pipeline ).
+     */
+    bool _isExecuted() const;
+
+    /** @return true if the input futures are ready */
+    bool _isReady() const;
+
+    /** @return true if the data of an output is released */
+    bool _isReleased() const;
+
     ExecutablePtr clone() const;
 
     struct Impl;
@@ -18,12 +18,412 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
-#include "futureMap.h"
 #include "pipeline.h"
+#include "arena.h"
+#include "inputPort.h"
+#include "workers.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace tuyau
 {
 
+namespace
+{
+
+/** Executable in the topological order of the pipeline */
+struct Node
+{
+    Executable* executable;
+    PipeFilter* pipeFilter; // Null for the other executables
+    Pipeline* pipeline; // Null for the other executables
+    std::vector< size_t > consumers; // Positions of the consumers in the order
+    size_t producerCount;
+    std::vector< size_t > releasedInputs; // Indices of the ReleasedOutputs
+
+    // Position of the consumer, which is executed right after the pipe
+    // filter, as it is the single consumer of the filter and the filter is
+    // its single producer and provides all its inputs. noConsumer if the
+    // filter is not fused with it.
+    size_t fusedConsumer;
+};
+
+typedef std::vector< Node > Nodes;
+
+const size_t noConsumer = std::numeric_limits< size_t >::max();
+
+/**
+ * Output of a pipe filter, which is not waited on, with the number of its
+ * consumers in the pipeline.
+ */
+struct ReleasedOutput
+{
+    Promise promise;
+    size_t consumerCount;
+};
+
+typedef std::vector< ReleasedOutput > ReleasedOutputs;
+typedef std::shared_ptr< ReleasedOutputs > ReleasedOutputsPtr;
+
+/** Flags of the nodes in an execution, allocated from the arena of the run */
+typedef std::vector< char, ArenaAllocator< char >> Flags;
+
+/**
+ * Counts the finished consumers of the outputs in an execution and releases
+ * the data of an output after its last consumer is finished.
+ */
+class OutputRelease
+{
+public:
+
+    /** The counts are allocated from the heap for the scheduled executions */
+    explicit OutputRelease( const ReleasedOutputsPtr& outputs )
+        : _outputs( outputs )
+        , _ownedCounts( new std::atomic< size_t >[ outputs->size() ])
+        , _counts( _ownedCounts.get( ))
+    {
+        for( size_t i = 0; i < _outputs->size(); ++i )
+            _counts[ i ] = (*_outputs)[ i ].consumerCount;
+    }
+
+    /** The counts are allocated from the arena of a synchronous execution */
+    OutputRelease( const ReleasedOutputsPtr& outputs, Arena& arena )
+        : _outputs( outputs )
+        , _counts( ArenaAllocator< std::atomic< size_t >>( arena )
+                       .allocate( outputs->size( )))
+    {
+        for( size_t i = 0; i < _outputs->size(); ++i )
+            new( &_counts[ i ] ) std::atomic< size_t >(
+                                     (*_outputs)[ i ].consumerCount );
+    }
+
+    void finish( const std::vector< size_t >& releasedInputs )
+    {
+        for( const size_t index: releasedInputs )
+        {
+            if( --_counts[ index ] == 0 )
+                (*_outputs)[ index ].promise.release();
+        }
+    }
+
+private:
+
+    const ReleasedOutputsPtr _outputs;
+    std::unique_ptr< std::atomic< size_t >[] > _ownedCounts;
+    std::atomic< size_t >* const _counts;
+};
+
+typedef std::shared_ptr< OutputRelease > OutputReleasePtr;
+
+/** Releases the consumed outputs after the scheduled executable is finished */
+class ReleasingExecutable : public Executable
+{
+public:
+
+    ReleasingExecutable( const ExecutablePtr& executable,
+                         const std::vector< size_t >& releasedInputs,
+                         const OutputReleasePtr& release )
+        : _executable( executable )
+        , _releasedInputs( releasedInputs )
+        , _release( release )
+    {}
+
+    void execute() final
+    {
+        struct Finish
+        {
+            ~Finish() { release.finish( releasedInputs ); }
+            OutputRelease& release;
+            const std::vector< size_t >& releasedInputs;
+        } finish = { *_release, _releasedInputs };
+
+        _executable->execute();
+    }
+
+    std::string getName() const final
+    {
+        return _executable->getName();
+    }
+
+    size_t getEstimatedOutputSize() const final
+    {
+        return _executable->getEstimatedOutputSize();
+    }
+
+    int getPriority() const final
+    {
+        return _executable->getPriority();
+    }
+
+    Futures getPostconditions() const final
+    {
+        return _executable->getPostconditions();
+    }
+
+    Futures getPreconditions() const final
+    {
+        return _executable->getPreconditions();
+    }
+
+    void reset() final
+    {
+        _executable->reset();
+    }
+
+    ExecutablePtr clone() const final
+    {
+        return ExecutablePtr( new ReleasingExecutable( _executable->clone(),
+                                                       _releasedInputs,
+                                                       _release ));
+    }
+
+private:
+
+    const ExecutablePtr _executable;
+    const std::vector< size_t > _releasedInputs;
+    const OutputReleasePtr _release;
+};
+
+/**
+ * Executes a chain of pipe filters, where each one is the single consumer of
+ * the previous one, back to back as one scheduled executable. The outputs of
+ * the filters are published as in the separate executions.
+ */
+class FusedExecutable : public Executable
+{
+public:
+
+    struct Member
+    {
+        ExecutablePtr executable;
+        std::vector< size_t > releasedInputs;
+    };
+
+    typedef std::vector< Member > Members;
+
+    FusedExecutable( const Members& members, const OutputReleasePtr& release )
+        : _members( members )
+        , _release( release )
+    {}
+
+    void execute() final
+    {
+        // The failing filters flush their outputs, so the consumers are
+        // executed as they would be in the separate executions
+        std::exception_ptr error;
+        for( const Member& member: _members )
+        {
+            try
+            {
+                member.executable->execute();
+            }
+            catch( ... )
+            {
+                if( !error )
+                    error = std::current_exception();
+            }
+
+            if( _release )
+                _release->finish( member.releasedInputs );
+        }
+
+        if( error )
+            std::rethrow_exception( error );
+    }
+
+    std::string getName() const final
+    {
+        std::string name;
+        for( const Member& member: _members )
+            name += ( name.empty() ? "" : "+" ) + member.executable->getName();
+        return name;
+    }
+
+    size_t getEstimatedOutputSize() const final
+    {
+        size_t size = 0;
+        for( const Member& member: _members )
+            size += member.executable->getEstimatedOutputSize();
+        return size;
+    }
+
+    int getPriority() const final
+    {
+        int priority = std::numeric_limits< int >::min();
+        for( const Member& member: _members )
+            priority = std::max( priority, member.executable->getPriority( ));
+        return priority;
+    }
+
+    Futures getPostconditions() const final
+    {
+        Futures futures;
+        for( const Member& member: _members )
+        {
+            const Futures& memberFutures = member.executable->getPostconditions();
+            futures.insert( futures.end(), memberFutures.begin(), memberFutures.end( ));
+        }
+        return futures;
+    }
+
+    /**
+     * @return the preconditions, which are not set by the chain itself, i.e.
+     * the ones of the head, as the other filters only consume the outputs of
+     * their producer in the chain
+     */
+    Futures getPreconditions() const final
+    {
+        Futures futures;
+        std::unordered_set< uint64_t > internal;
+        for( const Member& member: _members )
+        {
+            for( const auto& future: member.executable->getPreconditions( ))
+            {
+                if( internal.count( future.getId( )) == 0 )
+                    futures.push_back( future );
+            }
+
+            for( const auto& future: member.executable->getPostconditions( ))
+                internal.insert( future.getId( ));
+        }
+        return futures;
+    }
+
+    void reset() final
+    {
+        for( const Member& member: _members )
+            member.executable->reset();
+    }
+
+    ExecutablePtr clone() const final
+    {
+        Members members;
+        for( const Member& member: _members )
+            members.push_back({ member.executable->clone(), member.releasedInputs });
+        return ExecutablePtr( new FusedExecutable( members, _release ));
+    }
+
+private:
+
+    const Members _members;
+    const OutputReleasePtr _release;
+};
+
+bool isReady( const Executable& executable )
+{
+    for( const auto& future: executable.getPreconditions( ))
+    {
+        if( !future.isReady( ))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * The state of a parallel execution. The consumers are submitted to the
+ * workers when their last producer in the pipeline is finished.
+ */
+struct ParallelExecution
+{
+    typedef std::function< void( size_t ) > ExecuteFunc;
+
+    ParallelExecution( const Nodes& nodes_,
+                       const ExecuteFunc& executeNode_,
+                       OutputRelease& release_,
+                       Workers& workers_,
+                       Arena& arena )
+        : nodes( nodes_ )
+        , executeNode( executeNode_ )
+        , release( release_ )
+        , workers( workers_ )
+        , producerCounts( ArenaAllocator< std::atomic< size_t >>( arena )
+                              .allocate( nodes_.size( )))
+        , remaining( nodes_.size( ))
+    {
+        for( size_t i = 0; i < nodes.size(); ++i )
+            new( &producerCounts[ i ] ) std::atomic< size_t >(
+                                            nodes[ i ].producerCount );
+    }
+
+    void start()
+    {
+        for( size_t i = 0; i < nodes.size(); ++i )
+        {
+            if( nodes[ i ].producerCount == 0 )
+                submit( i );
+        }
+    }
+
+    void submit( const size_t index )
+    {
+        workers.submit( [ this, index ]{ execute( index ); });
+    }
+
+    void execute( size_t index )
+    {
+        // The fused consumers are executed by the same task, without going
+        // through the queue of the workers
+        while( index != noConsumer )
+        {
+            const Node& node = nodes[ index ];
+            try
+            {
+                executeNode( index );
+            }
+            catch( ... )
+            {
+                std::lock_guard< std::mutex > lock( mutex );
+                if( !error )
+                    error = std::current_exception();
+            }
+
+            release.finish( node.releasedInputs );
+            size_t next = noConsumer;
+            for( const size_t consumer: node.consumers )
+            {
+                if( --producerCounts[ consumer ] > 0 )
+                    continue;
+
+                if( consumer == node.fusedConsumer )
+                    next = consumer;
+                else
+                    submit( consumer );
+            }
+
+            // The execution can be finished and destroyed by the waiting
+            // thread after the last node, unless there is a next one
+            std::lock_guard< std::mutex > lock( mutex );
+            if( --remaining == 0 )
+                condition.notify_one();
+            index = next;
+        }
+    }
+
+    void wait()
+    {
+        std::unique_lock< std::mutex > lock( mutex );
+        condition.wait( lock, [ this ]{ return remaining == 0; });
+    }
+
+    const Nodes& nodes;
+    const ExecuteFunc& executeNode;
+    OutputRelease& release;
+    Workers& workers;
+    std::atomic< size_t >* const producerCounts; // From the arena
+    size_t remaining;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable condition;
+};
+
+}
+
 struct Pipeline::Impl
 {
     typedef std::map< std::string, const Pipeline > PipelineMap;
@@ -32,6 +432,8 @@ struct Pipeline::Impl
 
     Impl( Pipeline& pipeline )
         : _pipeline( pipeline )
+        , _connectionVersion( 0 )
+        , _fusion( false )
     {}
 
     void add( const std::string& name,
@@ -42,39 +444,357 @@ struct Pipeline::Impl
             throw std::runtime_error( name + " already exists");
 
         if( wait )
-        {
-            const Futures& futures = executable->getPostconditions();
-            _outFutures.insert( _outFutures.end(), futures.begin(), futures.end( ));
-        }
+            _waitExecutables.push_back( executable.get( ));
 
         _executableMap.emplace( std::piecewise_construct,
                                 std::forward_as_tuple( name ),
                                 std::forward_as_tuple( std::move( executable )));
+        _nodes.clear();
     }
 
-    void execute()
+    /**
+     * Sorts the executables topologically, where the edges are found by
+     * matching the preconditions to the postconditions of the producers. The
+     * order is cached until an executable is added or a connection changes.
+     */
+    const Nodes& getNodes()
     {
-        Executables executables = getExecutables();
-        Executables::iterator it = executables.begin();
-        while( !executables.empty( ))
+        const uint64_t connectionVersion = InputPort::getConnectionVersion();
+        if( !_nodes.empty() && connectionVersion == _connectionVersion )
+            return _nodes;
+
+        const Executables executables = getExecutables();
+        const std::vector< Executable* > nameOrder( executables.begin(),
+                                                    executables.end( ));
+        std::unordered_map< uint64_t, size_t > producers;
+        for( size_t i = 0; i < nameOrder.size(); ++i )
         {
-            Executable* executable = *it;
-            const FutureMap futureMap( executable->getPreconditions( ));
-            if( futureMap.isReady( ))
+            for( const auto& future: nameOrder[ i ]->getPostconditions( ))
+                producers[ future.getId() ] = i;
+        }
+
+        std::vector< std::vector< size_t >> consumers( nameOrder.size( ));
+        std::vector< size_t > producerCounts( nameOrder.size(), 0 );
+        for( size_t i = 0; i < nameOrder.size(); ++i )
+        {
+            for( const auto& future: nameOrder[ i ]->getPreconditions( ))
             {
-                executable->execute();
-                executables.erase( it );
-                it = executables.begin();
+                const auto it = producers.find( future.getId( ));
+                if( it == producers.end() || it->second == i )
+                    continue;
+
+                std::vector< size_t >& producerConsumers = consumers[ it->second ];
+                if( std::find( producerConsumers.begin(), producerConsumers.end(), i )
+                        != producerConsumers.end( ))
+                {
+                    continue;
+                }
+                producerConsumers.push_back( i );
+                ++producerCounts[ i ];
             }
-            else
+        }
+
+        std::vector< size_t > order;
+        std::vector< size_t > counts = producerCounts;
+        for( size_t i = 0; i < nameOrder.size(); ++i )
+        {
+            if( counts[ i ] == 0 )
+                order.push_back( i );
+        }
+
+        for( size_t i = 0; i < order.size(); ++i )
+        {
+            for( const size_t consumer: consumers[ order[ i ]] )
+            {
+                if( --counts[ consumer ] == 0 )
+                    order.push_back( consumer );
+            }
+        }
+
+        // The executables in cycles are never ready, they are kept at the end
+        // to be skipped like the others with unset inputs.
+        for( size_t i = 0; i < nameOrder.size(); ++i )
+        {
+            if( counts[ i ] > 0 )
+            {
+                order.push_back( i );
+                for( const size_t consumer: consumers[ i ] )
+                    --producerCounts[ consumer ];
+                producerCounts[ i ] = 0;
+                consumers[ i ].clear();
+            }
+        }
+
+        std::vector< size_t > positions( order.size( ));
+        for( size_t i = 0; i < order.size(); ++i )
+            positions[ order[ i ]] = i;
+
+        _nodes.clear();
+        for( const size_t index: order )
+        {
+            Node node = { nameOrder[ index ],
+                          dynamic_cast< PipeFilter* >( nameOrder[ index ]),
+                          dynamic_cast< Pipeline* >( nameOrder[ index ]), {},
+                          producerCounts[ index ], {}, noConsumer };
+            for( const size_t consumer: consumers[ index ] )
+                node.consumers.push_back( positions[ consumer ] );
+            _nodes.push_back( node );
+        }
+
+        setFusedConsumers();
+        setReleasedOutputs();
+
+        _connectionVersion = connectionVersion;
+        return _nodes;
+    }
+
+    /**
+     * Finds the executables to execute. The pipe filters, whose inputs and
+     * outputs did not change since their last execution, keep their outputs
+     * and are skipped, as well as the nested pipelines without executables to
+     * execute. The consumers of the changed executables are changed too. The
+     * pipe filters with released outputs are executed again only if a
+     * consumer is executed, which changes their other consumers as well. The
+     * outputs of the changed executables are reset afterwards.
+     * @return the flags of the executables to execute in the dependency order,
+     * allocated from the arena of the run
+     */
+    Flags getDirtyNodes( const Nodes& nodes )
+    {
+        const Flags dirty = findDirtyNodes( nodes, _arena );
+        resetOutputs( nodes, dirty, _arena );
+        return dirty;
+    }
+
+    /** @return the flags of the executables to execute, see getDirtyNodes() */
+    Flags findDirtyNodes( const Nodes& nodes, Arena& arena )
+    {
+        Flags dirty( nodes.size(), true, ArenaAllocator< char >( arena ));
+        Flags released( nodes.size(), false, ArenaAllocator< char >( arena ));
+        for( size_t i = 0; i < nodes.size(); ++i )
+        {
+            // The pipe filters record their executions, the failed ones and
+            // the ones dropped by the executor are dirty
+            PipeFilter* pipeFilter = nodes[ i ].pipeFilter;
+            if( pipeFilter && pipeFilter->_isExecuted( ))
+            {
+                dirty[ i ] = false;
+                released[ i ] = pipeFilter->_isReleased();
+            }
+            else if( nodes[ i ].pipeline )
+                dirty[ i ] = nodes[ i ].pipeline->_impl->isChanged( arena );
+        }
+
+        bool changed = true;
+        while( changed )
+        {
+            changed = false;
+            for( size_t i = 0; i < nodes.size(); ++i )
+            {
+                if( !dirty[ i ] )
+                    continue;
+
+                for( const size_t consumer: nodes[ i ].consumers )
+                {
+                    changed = changed || !dirty[ consumer ];
+                    dirty[ consumer ] = true;
+                }
+            }
+
+            for( size_t i = nodes.size(); i-- > 0; )
+            {
+                if( dirty[ i ] || !released[ i ] )
+                    continue;
+
+                for( const size_t consumer: nodes[ i ].consumers )
+                {
+                    if( dirty[ consumer ] )
+                    {
+                        dirty[ i ] = true;
+                        changed = true;
+                        break;
+                    }
+                }
+            }
+        }
+        return dirty;
+    }
+
+    /**
+     * Resets the outputs of the dirty pipe filters and of the dirty
+     * executables of the dirty nested pipelines, in the dependency order, so
+     * the nested pipelines find the reset outputs of their producers.
+     */
+    void resetOutputs( const Nodes& nodes, const Flags& dirty, Arena& arena )
+    {
+        for( size_t i = 0; i < nodes.size(); ++i )
+        {
+            if( !dirty[ i ] )
+                continue;
+
+            if( nodes[ i ].pipeFilter )
+                nodes[ i ].pipeFilter->_resetOutputs();
+            else if( nodes[ i ].pipeline )
             {
-                if( it == executables.end( ))
-                    break;
-                ++it;
+                Impl& nested = *nodes[ i ].pipeline->_impl;
+                const Nodes& nestedNodes = nested.getNodes();
+                nested.resetOutputs( nestedNodes,
+                                     nested.findDirtyNodes( nestedNodes, arena ), arena );
             }
         }
     }
 
+    /**
+     * @param arena allocates the scratch of the check
+     * @return true if the pipeline has executables to execute
+     */
+    bool isChanged( Arena& arena )
+    {
+        const Flags dirty = findDirtyNodes( getNodes(), arena );
+        return std::find( dirty.begin(), dirty.end(), true ) != dirty.end();
+    }
+
+    /** @return true if the inputs of the executable of the node are set */
+    static bool isReady( const Node& node )
+    {
+        return node.pipeFilter ? node.pipeFilter->_isReady()
+                               : tuyau::isReady( *node.executable );
+    }
+
+    /**
+     * Finds the single producer and single consumer chains of pipe filters,
+     * which are executed back to back. A consumer with inputs from out of the
+     * pipeline is not fused, as the chain would wait for them before
+     * executing its producer.
+     */
+    void setFusedConsumers()
+    {
+        if( !_fusion )
+            return;
+
+        for( Node& node: _nodes )
+        {
+            if( !node.pipeFilter || node.consumers.size() != 1 )
+                continue;
+
+            const Node& consumer = _nodes[ node.consumers.front() ];
+            if( !consumer.pipeFilter || consumer.producerCount != 1 )
+                continue;
+
+            std::unordered_set< uint64_t > outputs;
+            for( const auto& future: node.executable->getPostconditions( ))
+                outputs.insert( future.getId( ));
+
+            const Futures& inputs = consumer.executable->getPreconditions();
+            if( std::all_of( inputs.begin(), inputs.end(),
+                             [ & ]( const Future& future )
+                             { return outputs.count( future.getId( )) > 0; }))
+            {
+                node.fusedConsumer = node.consumers.front();
+            }
+        }
+    }
+
+    /**
+     * Finds the outputs of the pipe filters, which are not waited on, with
+     * their consumers in the pipeline. The consumers are counted once per
+     * output, even if they are connected to it through multiple ports.
+     */
+    void setReleasedOutputs()
+    {
+        // The scheduled executions keep the previous outputs
+        const ReleasedOutputsPtr releasedOutputs =
+                std::make_shared< ReleasedOutputs >();
+        _releasedOutputs = releasedOutputs;
+
+        std::unordered_map< uint64_t, size_t > outputs;
+        for( const Node& node: _nodes )
+        {
+            const PipeFilter* pipeFilter = node.pipeFilter;
+            if( !pipeFilter || isWaited( *pipeFilter ))
+                continue;
+
+            const Futures& futures = pipeFilter->getPostconditions();
+            const Promises promises = pipeFilter->_getOutputPromises();
+            auto promise = promises.begin();
+            for( const auto& future: futures )
+            {
+                outputs[ future.getId() ] = releasedOutputs->size();
+                releasedOutputs->push_back({ *promise++, 0 });
+            }
+        }
+
+        if( outputs.empty( ))
+            return;
+
+        for( Node& node: _nodes )
+        {
+            for( const auto& future: node.executable->getPreconditions( ))
+            {
+                const auto it = outputs.find( future.getId( ));
+                if( it == outputs.end() ||
+                    std::find( node.releasedInputs.begin(), node.releasedInputs.end(),
+                               it->second ) != node.releasedInputs.end( ))
+                {
+                    continue;
+                }
+
+                node.releasedInputs.push_back( it->second );
+                ++(*releasedOutputs)[ it->second ].consumerCount;
+            }
+        }
+    }
+
+    bool isWaited( const Executable& executable ) const
+    {
+        return std::find( _waitExecutables.begin(), _waitExecutables.end(), &executable )
+                != _waitExecutables.end();
+    }
+
+    void execute()
+    {
+        // The scratch of the previous run is freed in one step
+        _arena.release();
+
+        const Nodes& nodes = getNodes();
+        const Flags dirty = getDirtyNodes( nodes );
+        OutputRelease release( _releasedOutputs, _arena );
+        for( size_t i = 0; i < nodes.size(); ++i )
+        {
+            const Node& node = nodes[ i ];
+            if( dirty[ i ] && isReady( node ))
+                node.executable->execute();
+            release.finish( node.releasedInputs );
+        }
+    }
+
+    void execute( Workers& workers )
+    {
+        _arena.release();
+
+        const Nodes& nodes = getNodes();
+        if( nodes.empty( ))
+            return;
+
+        const Flags dirty = getDirtyNodes( nodes );
+        const ParallelExecution::ExecuteFunc executeNode =
+            [ &nodes, &dirty ]( const size_t index )
+            {
+                // Executables with unset external inputs are skipped as in
+                // the sequential execution
+                if( dirty[ index ] && isReady( nodes[ index ] ))
+                    nodes[ index ].executable->execute();
+            };
+
+        OutputRelease release( _releasedOutputs, _arena );
+        ParallelExecution execution( nodes, executeNode, release, workers, _arena );
+        execution.start();
+        execution.wait();
+
+        if( execution.error )
+            std::rethrow_exception( execution.error );
+    }
+
     Executables getExecutables() const
     {
         Executables executables;
@@ -85,6 +805,38 @@ struct Pipeline::Impl
         return executables;
     }
 
+    Pipeline replicate() const
+    {
+        tuyau::PipeFilterMap replicas;
+        for( const auto& nameExec: _executableMap )
+        {
+            const PipeFilter* pipeFilter =
+                    dynamic_cast< const PipeFilter* >( nameExec.second.get( ));
+            if( !pipeFilter )
+                throw std::logic_error( std::string( "Only pipe filters can be replicated: ")
+                                        + nameExec.first );
+
+            replicas.emplace( nameExec.first, pipeFilter->_replicate( ));
+        }
+
+        for( const auto& nameExec: _executableMap )
+        {
+            static_cast< const PipeFilter& >( *nameExec.second )
+                    ._connectReplicas( replicas );
+        }
+
+        Pipeline pipeline;
+        for( const auto& nameExec: _executableMap )
+        {
+            const bool wait = isWaited( *nameExec.second );
+            pipeline._add( nameExec.first,
+                           UniqueExecutablePtr(
+                               new PipeFilter( replicas.find( nameExec.first )->second )),
+                           wait );
+        }
+        return pipeline;
+    }
+
     Executable& getExecutable( const std::string& name )
     {
         if( _executableMap.count( name ) == 0 )
@@ -106,24 +858,80 @@ struct Pipeline::Impl
 
     Futures getPostconditions() const
     {
-        return _outFutures;
+        // The postconditions are collected on every call, as the futures of
+        // the executables change on reset
+        Futures outFutures;
+        for( const Executable* executable: _waitExecutables )
+        {
+            const Futures& futures = executable->getPostconditions();
+            outFutures.insert( outFutures.end(), futures.begin(), futures.end( ));
+        }
+        return outFutures;
     }
 
     void schedule( Executor& executor )
     {
-        for( auto& nameExec: _executableMap )
-            executor.schedule( nameExec.second->clone( ));
+        _arena.release();
+
+        const Nodes& nodes = getNodes();
+        const Flags dirty = getDirtyNodes( nodes );
+        const OutputReleasePtr release = _releasedOutputs->empty()
+                ? OutputReleasePtr()
+                : std::make_shared< OutputRelease >( _releasedOutputs );
+
+        // The fused consumers are scheduled with the head of their chain
+        Flags scheduled( nodes.size(), false, ArenaAllocator< char >( _arena ));
+        for( size_t i = 0; i < nodes.size(); ++i )
+        {
+            const Node& node = nodes[ i ];
+            if( !dirty[ i ] )
+            {
+                if( release )
+                    release->finish( node.releasedInputs );
+                continue;
+            }
+
+            if( scheduled[ i ] )
+                continue;
+
+            const Executable& executable = *node.executable;
+            if( node.fusedConsumer != noConsumer && dirty[ node.fusedConsumer ] )
+            {
+                FusedExecutable::Members members;
+                for( size_t index = i; index != noConsumer && dirty[ index ];
+                     index = nodes[ index ].fusedConsumer )
+                {
+                    const Node& member = nodes[ index ];
+                    members.push_back({ member.executable->clone(), member.releasedInputs });
+                    scheduled[ index ] = true;
+                }
+                executor.schedule( std::make_shared< FusedExecutable >( members, release ));
+                continue;
+            }
+
+            if( release && !node.releasedInputs.empty( ))
+                executor.schedule( std::make_shared< ReleasingExecutable >(
+                                       executable.clone(), node.releasedInputs, release ));
+            else
+                executor.schedule( executable.clone( ));
+        }
     }
 
     void reset()
     {
+        _arena.release();
         for( auto& nameExec: _executableMap )
             nameExec.second->reset();
     }
 
     Pipeline& _pipeline;
     ExecutableMap _executableMap;
-    Futures _outFutures;
+    std::vector< const Executable* > _waitExecutables;
+    Nodes _nodes;
+    uint64_t _connectionVersion;
+    bool _fusion;
+    ReleasedOutputsPtr _releasedOutputs;
+    Arena _arena; // Scratch of the current run
 };
 
 Pipeline::Pipeline()
@@ -151,6 +959,21 @@ void Pipeline::execute()
     _impl->execute();
 }
 
+void Pipeline::execute( Workers& workers )
+{
+    _impl->execute( workers );
+}
+
+Executables Pipeline::getExecutables() const
+{
+    return _impl->getExecutables();
+}
+
+Pipeline Pipeline::replicate() const
+{
+    return _impl->replicate();
+}
+
 Futures Pipeline::getPostconditions() const
 {
     return _impl->getPostconditions();
@@ -161,6 +984,12 @@ Futures Pipeline::getPreconditions() const
     return _impl->getPreconditions();
 }
 
+void Pipeline::setFusion( const bool enable )
+{
+    _impl->_fusion = enable;
+    _impl->_nodes.clear();
+}
+
 void Pipeline::reset()
 {
     _impl->reset();
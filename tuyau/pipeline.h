@@ -86,10 +86,62 @@ public:
     TUYAU_API Executable& getExecutable( const std::string& name );
 
     /**
-     * @copydoc Executable::execute
+     * @return the executables of the pipeline in the name order
+     */
+    TUYAU_API Executables getExecutables() const;
+
+    /**
+     * Replicates the pipeline, i.e. for executing multiple frames in flight
+     * ( see PipelineStream ). The pipe filters of the replica have their own
+     * ports, connected as in the pipeline, and share the filters with the
+     * pipeline, as the filters are immutable.
+     * @return the replica of the pipeline
+     * @throw std::logic_error if the pipeline has executables other than pipe
+     * filters or if pipe filters are connected to filters out of the pipeline
+     */
+    TUYAU_API Pipeline replicate() const;
+
+    /**
+     * Executes the executables in the dependency order. The order is computed
+     * once and cached until an executable is added or a port connection
+     * changes. The executables with unset inputs are skipped.
+     *
+     * The execution is incremental: the pipe filters, whose inputs and outputs
+     * did not change since their last execution, keep their outputs and are
+     * not executed again. When a manually set input is reset and set again
+     * ( see PipeFilter::getPromise() and Promise::reset() ), only the filter
+     * and its downstream filters, including the ones in nested pipelines, are
+     * reset and executed. reset() discards the execution history, so all
+     * executables are executed again.
      */
     TUYAU_API void execute() final;
 
+    /**
+     * Executes the executables in the dependency order like execute(), where
+     * the independent executables run in parallel on the workers. The call
+     * blocks until all executables are finished, so it should not be called
+     * from the threads of the given workers. The execution is incremental as
+     * in execute().
+     * @param workers run the executables
+     * @throw the first exception thrown by the executables, after all
+     * executables are finished
+     */
+    TUYAU_API void execute( Workers& workers );
+
+    /**
+     * Enables the fusion of the chains of pipe filters, where each filter is
+     * the single consumer of the previous one and the previous one provides
+     * all its inputs, i.e. the filters after the first one have no inputs
+     * from out of the chain, so the chain only waits for the inputs of its
+     * first filter. The filters of a chain are executed back to back by the
+     * same worker: execute( Workers& ) executes the next filter of the chain
+     * without going through the queue of the workers and schedule() schedules
+     * the chain as a single executable. The outputs of the filters in the
+     * chain are published as without the fusion.
+     * @param enable the fusion, it is disabled by default
+     */
+    TUYAU_API void setFusion( bool enable );
+
     /**
      * @copydoc Executable::getPostconditions
      */
@@ -101,6 +153,8 @@ public:
     TUYAU_API Futures getPreconditions() const final;
 
     /**
+     * Resets all executables and discards the execution history, so that
+     * the next execution or scheduling runs all of them.
      * @copydoc Executable::reset
      */
     TUYAU_API void reset() final;
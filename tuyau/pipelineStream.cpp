@@ -0,0 +1,310 @@
+
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "pipelineStream.h"
+#include "executor.h"
+#include "pipeFilter.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+namespace tuyau
+{
+
+namespace
+{
+
+/** A replica of the pipeline with the count of its running executables */
+struct Slot
+{
+    explicit Slot( const Pipeline& pipeline_ )
+        : pipeline( pipeline_.replicate( ))
+        , running( 0 )
+        , frame( 0 )
+        , canceled( false )
+    {}
+
+    void start( const size_t count )
+    {
+        std::lock_guard< std::mutex > lock( mutex );
+        running = count;
+        ++frame;
+        canceled = false;
+    }
+
+    void finish()
+    {
+        std::lock_guard< std::mutex > lock( mutex );
+        if( --running == 0 )
+            condition.notify_all();
+    }
+
+    void wait()
+    {
+        std::unique_lock< std::mutex > lock( mutex );
+        condition.wait( lock, [ this ]{ return running == 0; });
+    }
+
+    /** Waits until the given frame is finished or a new frame is started */
+    void wait( const size_t frame_ )
+    {
+        std::unique_lock< std::mutex > lock( mutex );
+        condition.wait( lock, [ this, frame_ ]
+                        { return running == 0 || frame != frame_; });
+    }
+
+    size_t getFrame()
+    {
+        std::lock_guard< std::mutex > lock( mutex );
+        return frame;
+    }
+
+    Pipeline pipeline;
+    size_t running;
+    size_t frame;
+    std::atomic< bool > canceled;
+    std::mutex mutex;
+    std::condition_variable condition;
+};
+
+typedef std::shared_ptr< Slot > SlotPtr;
+
+}
+
+struct PipelineStream::Impl
+{
+    /**
+     * Notifies the slot once, when the executable is executed or when it is
+     * dropped without execution ( i.e. by Executor::clear() ). It is shared by
+     * the clones of the executable. The outputs of a dropped pipe filter are
+     * flushed, so that its consumers are not blocked.
+     */
+    class SlotFinish
+    {
+    public:
+
+        SlotFinish( const SlotPtr& slot, PipeFilter* pipeFilter )
+            : _slot( slot )
+            , _pipeFilter( pipeFilter )
+            , _finished( false )
+        {}
+
+        ~SlotFinish()
+        {
+            if( _finished )
+                return;
+
+            if( _pipeFilter )
+                _pipeFilter->_flushOutputs();
+            finish();
+        }
+
+        void finish()
+        {
+            if( !_finished.exchange( true ))
+                _slot->finish();
+        }
+
+        bool isCanceled() const { return _slot->canceled; }
+        PipeFilter* getPipeFilter() const { return _pipeFilter; }
+
+    private:
+
+        const SlotPtr _slot;
+        PipeFilter* const _pipeFilter;
+        std::atomic< bool > _finished;
+    };
+
+    typedef std::shared_ptr< SlotFinish > SlotFinishPtr;
+
+    /**
+     * Executes an executable of a slot and notifies the slot when the execution
+     * is finished, so that the slot is not reset before all its executables ran.
+     * The pipe filters of a canceled frame flush their outputs without execution.
+     */
+    class SlotExecutable : public Executable
+    {
+    public:
+
+        SlotExecutable( const ExecutablePtr& executable, const SlotFinishPtr& finish )
+            : _executable( executable )
+            , _finish( finish )
+        {}
+
+        void execute() final
+        {
+            struct Finish
+            {
+                ~Finish() { finish.finish(); }
+                SlotFinish& finish;
+            } finish = { *_finish };
+
+            if( _finish->getPipeFilter() && _finish->isCanceled( ))
+                _finish->getPipeFilter()->_flushOutputs();
+            else
+                _executable->execute();
+        }
+
+        std::string getName() const final
+        {
+            return _executable->getName();
+        }
+
+        size_t getEstimatedOutputSize() const final
+        {
+            return _executable->getEstimatedOutputSize();
+        }
+
+        int getPriority() const final
+        {
+            return _executable->getPriority();
+        }
+
+        Futures getPostconditions() const final
+        {
+            return _executable->getPostconditions();
+        }
+
+        Futures getPreconditions() const final
+        {
+            return _executable->getPreconditions();
+        }
+
+        void reset() final
+        {
+            _executable->reset();
+        }
+
+        ExecutablePtr clone() const final
+        {
+            return ExecutablePtr( new SlotExecutable( _executable->clone(), _finish ));
+        }
+
+    private:
+
+        const ExecutablePtr _executable;
+        const SlotFinishPtr _finish;
+    };
+
+    Impl( const Pipeline& pipeline,
+          Executor& executor,
+          const size_t maxFramesInFlight )
+        : _executor( executor )
+        , _next( 0 )
+    {
+        if( maxFramesInFlight == 0 )
+            throw std::logic_error( "At least one frame should be in flight" );
+
+        for( size_t i = 0; i < maxFramesInFlight; ++i )
+            _slots.push_back( std::make_shared< Slot >( pipeline ));
+    }
+
+    ~Impl()
+    {
+        cancel();
+    }
+
+    Pipeline& push()
+    {
+        const SlotPtr& slot = _slots[ _next++ % _slots.size() ];
+        slot->wait();
+
+        // cancel() does not flush the inputs while the slot is reset
+        std::lock_guard< std::mutex > lock( _mutex );
+        slot->pipeline.reset();
+
+        const Executables executables = slot->pipeline.getExecutables();
+        slot->start( executables.size( ));
+        for( Executable* executable: executables )
+        {
+            const SlotFinishPtr finish = std::make_shared< SlotFinish >(
+                        slot, dynamic_cast< PipeFilter* >( executable ));
+            _executor.schedule( std::make_shared< SlotExecutable >( executable->clone(),
+                                                                    finish ));
+        }
+        return slot->pipeline;
+    }
+
+    void wait()
+    {
+        for( const SlotPtr& slot: _slots )
+            slot->wait();
+    }
+
+    void cancel()
+    {
+        // The frames started by a concurrent push() are not canceled
+        std::vector< size_t > frames;
+        {
+            std::lock_guard< std::mutex > lock( _mutex );
+            for( const SlotPtr& slot: _slots )
+            {
+                frames.push_back( slot->getFrame( ));
+                slot->canceled = true;
+                for( Executable* executable: slot->pipeline.getExecutables( ))
+                {
+                    PipeFilter* pipeFilter = dynamic_cast< PipeFilter* >( executable );
+                    if( pipeFilter )
+                        pipeFilter->_flushInputs();
+                }
+            }
+        }
+
+        for( size_t i = 0; i < _slots.size(); ++i )
+            _slots[ i ]->wait( frames[ i ]);
+    }
+
+    Executor& _executor;
+    std::vector< SlotPtr > _slots;
+    size_t _next;
+    std::mutex _mutex;
+};
+
+PipelineStream::PipelineStream( const Pipeline& pipeline,
+                                Executor& executor,
+                                const size_t maxFramesInFlight )
+    : _impl( new Impl( pipeline, executor, maxFramesInFlight ))
+{}
+
+PipelineStream::~PipelineStream()
+{}
+
+Pipeline& PipelineStream::push()
+{
+    return _impl->push();
+}
+
+void PipelineStream::wait()
+{
+    _impl->wait();
+}
+
+void PipelineStream::cancel()
+{
+    _impl->cancel();
+}
+
+size_t PipelineStream::getMaxFramesInFlight() const
+{
+    return _impl->_slots.size();
+}
+
+}
@@ -0,0 +1,97 @@
+
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _PipelineStream_h_
+#define _PipelineStream_h_
+
+#include <tuyau/api.h>
+#include "types.h"
+#include "pipeline.h"
+
+namespace tuyau
+{
+
+/**
+ * Streams frames through a pipeline, where multiple frames are in flight at
+ * the same time. Each slot of the stream has a replica of the pipeline ( see
+ * Pipeline::replicate() ), so that the producers can start a new frame while
+ * the consumers are still processing the previous ones. The number of slots
+ * bounds the frames in flight and the memory used by their port data.
+ *
+ * The frames are started from a single thread, cancel() can be called from
+ * another thread.
+ */
+class PipelineStream
+{
+public:
+
+    /**
+     * @param pipeline is replicated for each frame in flight
+     * @param executor executes the frames
+     * @param maxFramesInFlight is the number of slots
+     * @throw std::logic_error if the pipeline can not be replicated
+     */
+    TUYAU_API PipelineStream( const Pipeline& pipeline,
+                              Executor& executor,
+                              size_t maxFramesInFlight = 2 );
+
+    /** Cancels the frames in flight ( see cancel() ) */
+    TUYAU_API ~PipelineStream();
+
+    /**
+     * Starts a new frame. If all slots are in flight, blocks until the oldest
+     * frame is finished. The pipeline of the slot is reset and scheduled.
+     * @return the pipeline of the frame. The inputs of the frame are set
+     * through its pipe filters ( PipeFilter::getPromise() ) and the results
+     * are read from its postconditions. The pipeline is reused by the
+     * frame which is started maxFramesInFlight frames later, however the
+     * futures retrieved before keep their values. All the inputs of the
+     * frame have to be set, otherwise the frame does not finish until it is
+     * canceled ( see cancel() ). The executables of the frame dropped by
+     * Executor::clear() finish the frame without execution, when the
+     * executor releases them.
+     */
+    TUYAU_API Pipeline& push();
+
+    /** Waits until all frames in flight are finished */
+    TUYAU_API void wait();
+
+    /**
+     * Cancels the frames in flight and waits until they are finished. The
+     * inputs of the frames, which are not set yet, are flushed and the
+     * filters, which are not executed yet, flush their outputs without
+     * execution, so that the frames finish without results.
+     * It releases a push() waiting for a slot in another thread. The inputs
+     * should not be set concurrently.
+     */
+    TUYAU_API void cancel();
+
+    /** @return the maximum number of frames in flight */
+    TUYAU_API size_t getMaxFramesInFlight() const;
+
+private:
+
+    struct Impl;
+    std::unique_ptr< Impl > _impl;
+};
+
+}
+
+#endif // _PipelineStream_h_
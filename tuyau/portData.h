@@ -21,10 +21,107 @@
 #define _PortData_h_
 
 #include "types.h"
+#include "blockPool.h"
+
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 namespace tuyau
 {
 
+/**
+ * Combines the hash values, i.e. for the hashes of the elements of a container.
+ * @param seed is the combined hash value
+ * @param hash is the hash value to be combined
+ * @return the combined hash value
+ */
+inline size_t combineHash( const size_t seed, const size_t hash )
+{
+    return seed ^ ( hash + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 ));
+}
+
+/**
+ * Hashes the content of the port data for the memoization of the pure filters
+ * ( see Filter::isPure() ). It is enabled for the arithmetic, enum and string
+ * types and the vectors of them. Other types are enabled by specialization:
+ *
+ * template<> struct DataHash< MyData >
+ * {
+ *     static const bool enabled = true;
+ *     size_t operator()( const MyData& data ) const;
+ * };
+ *
+ * The hashes only select the cached outputs, the inputs are compared with
+ * operator==, which the enabled types have to provide.
+ */
+template< class T, class Enable = void >
+struct DataHash
+{
+    static const bool enabled = false;
+    size_t operator()( const T& ) const { return 0; }
+};
+
+template< class T >
+struct DataHash< T, typename std::enable_if< std::is_arithmetic< T >::value >::type >
+{
+    static const bool enabled = true;
+    size_t operator()( const T& value ) const { return std::hash< T >()( value ); }
+};
+
+template< class T >
+struct DataHash< T, typename std::enable_if< std::is_enum< T >::value >::type >
+{
+    static const bool enabled = true;
+    size_t operator()( const T& value ) const
+    {
+        typedef typename std::underlying_type< T >::type UnderlyingT;
+        return std::hash< UnderlyingT >()( static_cast< UnderlyingT >( value ));
+    }
+};
+
+template<>
+struct DataHash< std::string >
+{
+    static const bool enabled = true;
+    size_t operator()( const std::string& value ) const
+    {
+        return std::hash< std::string >()( value );
+    }
+};
+
+template< class T >
+struct DataHash< std::vector< T >, typename std::enable_if< DataHash< T >::enabled >::type >
+{
+    static const bool enabled = true;
+    size_t operator()( const std::vector< T >& values ) const
+    {
+        size_t hash = values.size();
+        for( const T& value: values )
+            hash = combineHash( hash, DataHash< T >()( value ));
+        return hash;
+    }
+};
+
+/**
+ * Compares the data of the hashable types ( see DataHash ).
+ * @return true if the data are equal, false if the type is not hashable
+ */
+template< class T >
+bool isDataEqual( const T& lhs, const T& rhs,
+                  typename std::enable_if< DataHash< T >::enabled >::type* = nullptr )
+{
+    return lhs == rhs;
+}
+
+template< class T >
+bool isDataEqual( const T&, const T&,
+                  typename std::enable_if< !DataHash< T >::enabled >::type* = nullptr )
+{
+    return false;
+}
+
 /**
  * Base class for keeping the track for types of data
  * by using the std::type_index.
@@ -34,6 +131,20 @@ class PortData
 public:
     const std::type_index dataType;
 
+    /**
+     * Hashes the content of the data ( see DataHash ).
+     * @param hash is set to the hash value of the data
+     * @return false if the data type is not hashable
+     */
+    virtual bool getHash( size_t& hash ) const = 0;
+
+    /**
+     * Compares the content of the data of the hashable types ( see DataHash ).
+     * @param data is the data to be compared with
+     * @return true if the data have the same type and equal content
+     */
+    virtual bool isEqual( const PortData& data ) const = 0;
+
 protected:
     explicit PortData( const std::type_index& dataType_ )
         : dataType( dataType_ ) {}
@@ -41,7 +152,13 @@ protected:
 };
 
 /**
- * Holds the T typed data.
+ * Tag for constructing the data of a PortDataT in place.
+ */
+struct InPlace {};
+
+/**
+ * Holds the T typed data. The data is either stored in the object ( copied,
+ * moved or constructed in place ) or shared with a given std::shared_ptr.
  */
 template< class T>
 struct PortDataT final : public PortData
@@ -52,17 +169,87 @@ struct PortDataT final : public PortData
      */
     explicit PortDataT( const T& data_ )
         : PortData( getType< T >())
-        , data( data_ )
+        , data( *new( &_storage ) T( data_ ))
+    {}
+
+    /**
+     * Constructor
+     * @param data_ is moved
+     */
+    explicit PortDataT( T&& data_ )
+        : PortData( getType< T >())
+        , data( *new( &_storage ) T( std::move( data_ )))
     {}
 
-    ~PortDataT() {}
-    const T data;
+    /**
+     * Constructs the data in place
+     * @param args are the arguments for the construction of T
+     */
+    template< class... Args >
+    explicit PortDataT( InPlace, Args&&... args )
+        : PortData( getType< T >())
+        , data( *new( &_storage ) T( std::forward< Args >( args )... ))
+    {}
+
+    /**
+     * Constructor
+     * @param data_ is shared, not copied
+     */
+    explicit PortDataT( const std::shared_ptr< const T >& data_ )
+        : PortData( getType< T >())
+        , _shared( data_ )
+        , data( *data_ )
+    {}
+
+    ~PortDataT()
+    {
+        if( !_shared )
+            data.~T();
+    }
+
+    bool getHash( size_t& hash ) const final
+    {
+        if( !DataHash< T >::enabled )
+            return false;
+
+        hash = DataHash< T >()( data );
+        return true;
+    }
+
+    bool isEqual( const PortData& other ) const final
+    {
+        if( other.dataType != dataType )
+            return false;
+
+        return isDataEqual( data, static_cast< const PortDataT< T >& >( other ).data );
+    }
+
+private:
+    typename std::aligned_storage< sizeof( T ),
+                                   std::alignment_of< T >::value >::type _storage;
+    const std::shared_ptr< const T > _shared;
+
+public:
+    const T& data;
 
     PortDataT( const PortDataT< T >& ) = delete;
     PortDataT( PortDataT< T >&& ) = delete;
     PortDataT< T >& operator=( const PortDataT< T >& ) = delete;
 };
 
+/**
+ * Creates the port data and its reference counts in a single block of the
+ * BlockPool, so the small port data are recycled instead of allocated.
+ * @param args are the arguments for the construction of PortDataT< T >
+ * @return the port data
+ */
+template< class T, class... Args >
+std::shared_ptr< PortDataT< T >> makePortData( Args&&... args )
+{
+    return std::allocate_shared< PortDataT< T >>( PoolAllocator< PortDataT< T >>(),
+                                                   std::forward< Args >( args )... );
+}
+
 }
 
 #endif // _PortData_h_
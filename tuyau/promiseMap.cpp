@@ -25,19 +25,29 @@ namespace tuyau
 namespace
 {
 
-const std::string ALL_PROMISES = "ALL_PROMISES";
+typedef std::pair< std::string, Promise > NamePromisePair;
 
+/** Promises are ordered by name, which gives the port handles */
+bool lessName( const NamePromisePair& namePromise, const std::string& name )
+{
+    return namePromise.first < name;
 }
 
-typedef std::map< std::string, Promise > NamePromiseMap;
-typedef NamePromiseMap::value_type NamePromisePair;
+}
 
 struct PromiseMap::Impl
 {
     Impl( const Promises& promises )
     {
         for( const auto& promise: promises )
-            _promiseMap.insert({ promise.getName(), promise });
+        {
+            const std::string name = promise.getName();
+            const auto it = std::lower_bound( _promises.begin(),
+                                              _promises.end(),
+                                              name, lessName );
+            if( it == _promises.end() || it->first != name )
+                _promises.insert( it, { name, promise });
+        }
     }
 
     void throwError( const std::string& name ) const
@@ -45,48 +55,39 @@ struct PromiseMap::Impl
         throw std::logic_error( std::string( "Unknown promise name: ") + name );
     }
 
-    bool hasPromise( const std::string& name ) const
+    void flush()
     {
-        return _promiseMap.count( name ) > 0;
+        for( auto& namePromise: _promises )
+            namePromise.second.flush();
     }
 
-    void flush( const std::string& name ) const
+    void reset()
     {
-        getPromise( name ).flush();
+        for( auto& namePromise: _promises )
+            namePromise.second.reset();
     }
 
-    void flush() const
+    Promise& getPromise( const std::string& name )
     {
-        for( auto& namePromise: _promiseMap )
-        {
-            Promise promise = namePromise.second;
-            promise.flush();
-        }
-    }
+        const auto it = std::lower_bound( _promises.begin(), _promises.end(),
+                                          name, lessName );
+        if( it == _promises.end() || it->first != name )
+            throwError( name );
 
-    void reset( const std::string& name ) const
-    {
-        getPromise( name ).reset();
+        return it->second;
     }
 
-    void reset() const
+    Promise& getPromise( const PortHandle& handle )
     {
-        for( auto& namePromise: _promiseMap )
+        if( handle.index >= _promises.size( ))
         {
-            Promise promise = namePromise.second;
-            promise.reset();
+            throw std::logic_error( std::string( "Unknown port handle: ")
+                                    + std::to_string( handle.index ));
         }
+        return _promises[ handle.index ].second;
     }
 
-    Promise getPromise( const std::string& name ) const
-    {
-        if( !hasPromise( name ))
-            throwError( name );
-
-        return _promiseMap.find( name )->second;
-    }
-
-    NamePromiseMap _promiseMap;
+    std::vector< NamePromisePair > _promises;
 };
 
 PromiseMap::PromiseMap( const Promises& promises )
@@ -98,7 +99,12 @@ PromiseMap::~PromiseMap()
 
 void PromiseMap::flush( const std::string& name ) const
 {
-    _impl->flush( name );
+    _impl->getPromise( name ).flush();
+}
+
+void PromiseMap::flush( const PortHandle& handle ) const
+{
+    _impl->getPromise( handle ).flush();
 }
 
 void PromiseMap::flush() const
@@ -108,12 +114,12 @@ void PromiseMap::flush() const
 
 void PromiseMap::reset( const std::string& name) const
 {
-    _impl->reset( name );
+    _impl->getPromise( name ).reset();
 }
 
 void PromiseMap::reset() const
 {
-    _impl->flush();
+    _impl->reset();
 }
 
 Promise PromiseMap::getPromise( const std::string& name ) const
@@ -121,4 +127,9 @@ Promise PromiseMap::getPromise( const std::string& name ) const
     return _impl->getPromise( name );
 }
 
+Promise& PromiseMap::getPromise( const PortHandle& handle ) const
+{
+    return _impl->getPromise( handle );
+}
+
 }
@@ -36,6 +36,10 @@ class PromiseMap
 
 public:
 
+    /**
+     * @param promises is the list of promises. The port handles are the
+     * positions of the promises in the name order.
+     */
     TUYAU_API explicit PromiseMap( const Promises& promises );
     TUYAU_API ~PromiseMap();
 
@@ -45,6 +49,14 @@ public:
      */
     TUYAU_API Promise getPromise( const std::string& name ) const;
 
+    /**
+     * @param handle of the port
+     * @return the promise related to the port, without copying it.
+     * @throw std::logic_error when there is no promise associated with the
+     * given handle
+     */
+    TUYAU_API Promise& getPromise( const PortHandle& handle ) const;
+
     /**
      * Sets the port with the value.
      * @param name of the promise
@@ -60,6 +72,111 @@ public:
         getPromise( name ).set( value );
     }
 
+    /**
+     * Sets the port with the value, without copying it.
+     * @param name of the promise
+     * @param value to be moved
+     * @throw std::logic_error when there is no promise associated with the
+     * given name
+     * @throw std::runtime_error when the port data is not exact
+     * type T
+     */
+    template< class T >
+    void set( const std::string& name, T&& value ) const
+    {
+        getPromise( name ).set( std::forward< T >( value ));
+    }
+
+    /**
+     * Sets the port with a value constructed in place.
+     * @param name of the promise
+     * @param args are the arguments for the construction of T
+     * @throw std::logic_error when there is no promise associated with the
+     * given name
+     * @throw std::runtime_error when the port data is not exact
+     * type T
+     */
+    template< class T, class... Args >
+    void emplace( const std::string& name, Args&&... args ) const
+    {
+        getPromise( name ).emplace< T >( std::forward< Args >( args )... );
+    }
+
+    /**
+     * Sets the port with a shared value, without copying it.
+     * @param name of the promise
+     * @param value to be shared
+     * @throw std::logic_error when there is no promise associated with the
+     * given name
+     * @throw std::runtime_error when the port data is not exact
+     * type T or the value is empty
+     */
+    template< class T >
+    void adopt( const std::string& name, const std::shared_ptr< T >& value ) const
+    {
+        getPromise( name ).adopt( value );
+    }
+
+    /**
+     * Sets the port with the value.
+     * @param handle of the port
+     * @param value to be set
+     * @throw std::logic_error when there is no promise associated with the
+     * given handle
+     * @throw std::runtime_error when the port data is not exact
+     * type T
+     */
+    template< class T >
+    void set( const PortHandle& handle, const T& value ) const
+    {
+        getPromise( handle ).set( value );
+    }
+
+    /**
+     * Sets the port with the value, without copying it.
+     * @param handle of the port
+     * @param value to be moved
+     * @throw std::logic_error when there is no promise associated with the
+     * given handle
+     * @throw std::runtime_error when the port data is not exact
+     * type T
+     */
+    template< class T >
+    void set( const PortHandle& handle, T&& value ) const
+    {
+        getPromise( handle ).set( std::forward< T >( value ));
+    }
+
+    /**
+     * Sets the port with a value constructed in place.
+     * @param handle of the port
+     * @param args are the arguments for the construction of T
+     * @throw std::logic_error when there is no promise associated with the
+     * given handle
+     * @throw std::runtime_error when the port data is not exact
+     * type T
+     */
+    template< class T, class... Args >
+    void emplace( const PortHandle& handle, Args&&... args ) const
+    {
+        getPromise( handle ).emplace< T >( std::forward< Args >( args )... );
+    }
+
+    /**
+     * Sets the port with a shared value, without copying it.
+     * @param handle of the port
+     * @param value to be shared
+     * @throw std::logic_error when there is no promise associated with the
+     * given handle
+     * @throw std::runtime_error when the port data is not exact
+     * type T or the value is empty
+     */
+    template< class T >
+    void adopt( const PortHandle& handle, const std::shared_ptr< T >& value ) const
+    {
+        getPromise( handle ).adopt( value );
+    }
+
     /**
      * Writes empty values to promises which are not set already.
      * @param name of the promise.
@@ -68,6 +185,14 @@ public:
      */
     TUYAU_API void flush( const std::string& name ) const;
 
+    /**
+     * Writes an empty value to the promise of the port if it is not set.
+     * @param handle of the port.
+     * @throw std::logic_error when there is no promise associated with the
+     * given handle
+     */
+    TUYAU_API void flush( const PortHandle& handle ) const;
+
     /**
      * Writes empty values to promises which are not set already.
      * @throw std::logic_error when there is no promise associated with the
@@ -17,127 +17,568 @@
  * along with this library; if not, write to the Free Software Foundation, Inc.,
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
-
 #include "pushExecutor.h"
 
-#include "filter.h"
 #include "workers.h"
 #include "executable.h"
-#include "futureMap.h"
 #include "futurePromise.h"
-#include "pipeFilter.h"
-#include "mtQueue.h"
-
-#include <boost/thread.hpp>
+#include "schedulingPolicy.h"
+#include "trace.h"
 
-#include <algorithm>
-#include <iterator>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <unordered_map>
 
 namespace tuyau
 {
 
-bool operator<( const Future& future1, const Future& future2 )
+namespace
 {
-    return future1.getId() < future2.getId();
-}
 
-struct PushExecutor::Impl
+/**
+ * The estimated output size of a scheduled executable, which is reserved from
+ * the memory budget while its outputs are needed.
+ */
+struct Reservation
 {
+    explicit Reservation( const size_t size_ )
+        : size( size_ )
+        , consumers( 0 )
+        , finished( false )
+        , reserved( false )
+    {}
 
-    Impl( const size_t threadCount,
-          const std::string& threadPoolName,
-          const WorkerSetupFunc& setupFunc )
-        : _workers( threadCount, threadPoolName, setupFunc )
-        , _unlockPromise( DataInfo( "LoopUnlock", getType< bool >( )))
-        , _workThread( boost::thread( boost::bind( &Impl::schedule, this )))
+    const size_t size;
+    size_t consumers; // Unfinished consumers scheduled on the executor
+    bool finished;
+    bool reserved;
+    std::vector< uint64_t > outputIds;
+};
+
+typedef std::shared_ptr< Reservation > ReservationPtr;
+
+/**
+ * A scheduled executable with the count of its unsatisfied preconditions. The
+ * ready callbacks of the preconditions decrement the count and the last one
+ * dispatches the executable to the workers.
+ */
+struct PendingExecutable
+{
+    PendingExecutable( const ExecutablePtr& executable_,
+                       const size_t epoch_,
+                       const size_t unsatisfied_ )
+        : executable( executable_ )
+        , epoch( epoch_ )
+        , unsatisfied( unsatisfied_ )
     {}
 
-    ~Impl()
+    bool satisfy()
+    {
+        return --unsatisfied == 0;
+    }
+
+    const ExecutablePtr executable;
+    const size_t epoch;
+    std::atomic< size_t > unsatisfied;
+
+    // Only set when the executable is scheduled with a memory budget
+    ReservationPtr reservation;
+    std::vector< ReservationPtr > producers;
+};
+
+typedef std::shared_ptr< PendingExecutable > PendingExecutablePtr;
+typedef std::vector< PendingExecutablePtr > PendingExecutables;
+
+/**
+ * Accounts the estimated output sizes of the executables against the memory
+ * budget. The size of an executable is reserved when it is dispatched and
+ * returned when its consumers, which are scheduled on the executor, are
+ * finished ( or when it is finished, if it has no consumers ). The ready
+ * executables, which exceed the budget, are deferred until enough memory is
+ * returned. The deferred executables are dispatched in the order of the
+ * memory they need minus the memory they return on completion, so the
+ * consumers which free their inputs come first. An executable is always
+ * dispatched when no budgeted executable is running, so the execution
+ * progresses even if a single executable exceeds the budget.
+ */
+class MemoryBudget
+{
+public:
+
+    MemoryBudget()
+        : _budget( 0 )
+        , _used( 0 )
+        , _running( 0 )
+    {}
+
+    bool isEnabled() const
+    {
+        return _budget > 0;
+    }
+
+    size_t getBudget() const
+    {
+        return _budget;
+    }
+
+    size_t getUsed() const
+    {
+        ScopedLock lock( _mutex );
+        return _used;
+    }
+
+    void setBudget( const size_t budget, PendingExecutables& ready )
+    {
+        ScopedLock lock( _mutex );
+        _budget = budget;
+        getReady( ready );
+    }
+
+    /** Creates the reservation of a scheduled executable */
+    void add( PendingExecutable& pending,
+              const Futures& preconditions )
+    {
+        const ReservationPtr reservation =
+                std::make_shared< Reservation >( pending.executable->getEstimatedOutputSize( ));
+        for( const auto& future: pending.executable->getPostconditions( ))
+            reservation->outputIds.push_back( future.getId( ));
+
+        ScopedLock lock( _mutex );
+        for( const auto& future: preconditions )
+        {
+            const auto it = _producers.find( future.getId( ));
+            if( it == _producers.end() ||
+                std::find( pending.producers.begin(), pending.producers.end(), it->second )
+                    != pending.producers.end( ))
+            {
+                continue;
+            }
+
+            ++it->second->consumers;
+            pending.producers.push_back( it->second );
+        }
+
+        for( const uint64_t id: reservation->outputIds )
+            _producers[ id ] = reservation;
+        pending.reservation = reservation;
+    }
+
+    /**
+     * @return true if the executable can be dispatched, otherwise it is
+     * deferred
+     */
+    bool acquire( const PendingExecutablePtr& pending )
+    {
+        ScopedLock lock( _mutex );
+        if( !fits( *pending->reservation ))
+        {
+            _deferred.emplace( getPriority( *pending ), pending );
+            return false;
+        }
+
+        reserve( *pending->reservation );
+        return true;
+    }
+
+    /**
+     * Returns the memory of the inputs which are not needed any more.
+     * @param ready is filled with the deferred executables which fit into
+     * the budget
+     */
+    void finish( const PendingExecutable& pending, PendingExecutables& ready )
+    {
+        ScopedLock lock( _mutex );
+        --_running;
+
+        Reservation& reservation = *pending.reservation;
+        reservation.finished = true;
+        for( const ReservationPtr& producer: pending.producers )
+        {
+            // The consumers of the producers are dropped on clear()
+            if( producer->consumers == 0 )
+                continue;
+
+            if( --producer->consumers == 0 && producer->finished )
+                free( *producer );
+        }
+
+        if( reservation.consumers == 0 )
+            free( reservation );
+
+        getReady( ready );
+    }
+
+    /**
+     * Drops the deferred executables and the consumers of the producers, as
+     * the executables scheduled before Executor::clear() are not executed.
+     */
+    void clear()
+    {
+        ScopedLock lock( _mutex );
+        _deferred.clear();
+
+        std::vector< ReservationPtr > producers;
+        for( const auto& idReservation: _producers )
+            producers.push_back( idReservation.second );
+        _producers.clear();
+
+        for( const ReservationPtr& producer: producers )
+        {
+            producer->consumers = 0;
+            if( producer->finished )
+                free( *producer );
+        }
+    }
+
+private:
+
+    bool fits( const Reservation& reservation ) const
+    {
+        return _budget == 0 || _running == 0 || _used + reservation.size <= _budget;
+    }
+
+    void reserve( Reservation& reservation )
+    {
+        ++_running;
+        _used += reservation.size;
+        reservation.reserved = true;
+    }
+
+    void free( Reservation& reservation )
+    {
+        if( !reservation.reserved )
+            return;
+
+        _used -= reservation.size;
+        reservation.reserved = false;
+        for( const uint64_t id: reservation.outputIds )
+        {
+            const auto it = _producers.find( id );
+            if( it != _producers.end() && it->second.get() == &reservation )
+                _producers.erase( it );
+        }
+    }
+
+    /** @return the memory the executable needs minus the memory it returns */
+    int64_t getPriority( const PendingExecutable& pending ) const
+    {
+        int64_t priority = pending.reservation->size;
+        for( const ReservationPtr& producer: pending.producers )
+        {
+            if( producer->consumers == 1 && producer->finished )
+                priority -= producer->size;
+        }
+        return priority;
+    }
+
+    void getReady( PendingExecutables& ready )
+    {
+        while( !_deferred.empty( ))
+        {
+            const auto it = _deferred.begin();
+            if( !fits( *it->second->reservation ))
+                return;
+
+            reserve( *it->second->reservation );
+            ready.push_back( it->second );
+            _deferred.erase( it );
+        }
+    }
+
+    mutable boost::mutex _mutex;
+    std::atomic< size_t > _budget;
+    size_t _used;
+    size_t _running;
+    std::multimap< int64_t, PendingExecutablePtr > _deferred;
+    std::unordered_map< uint64_t, ReservationPtr > _producers;
+};
+
+/**
+ * The ready callbacks can be called after the executor is destroyed ( i.e. when
+ * the promises are set later ), so they only keep a reference to the dispatcher.
+ */
+struct Dispatcher : public std::enable_shared_from_this< Dispatcher >
+{
+    Dispatcher( const size_t threadCount,
+                const std::string& threadPoolName,
+                const WorkerSetupFunc& setupFunc,
+                const Workers::QueueMode queueMode,
+                const Workers::Cores& cores )
+        : _workers( new Workers( threadCount, threadPoolName, setupFunc,
+                                 WorkerDestroyFunc(), queueMode, cores ))
+        , _epoch( 0 )
+    {}
+
+    void dispatch( const PendingExecutablePtr& pending )
+    {
+        if( pending->epoch != _epoch )
+            return;
+
+        if( pending->reservation && !_budget.acquire( pending ))
+            return;
+
+        submit( pending );
+    }
+
+    void submit( const PendingExecutablePtr& pending );
+
+    /**
+     * Executes the highest ranked ready executable. A worker task is submitted
+     * for each executable in the ready queue.
+     */
+    void executeReady( const SchedulingPolicyPtr& policy )
     {
-        _mtWorkQueue.clear();
-        _mtWorkQueue.push( 0 );
+        PendingExecutablePtr pending;
+        {
+            ScopedLock lock( _readyMutex );
+            const auto it = _ready.begin();
+            pending = it->second;
+            _ready.erase( it );
+        }
+
+        if( pending->epoch != _epoch )
         {
-            ScopedLock lock( _promiseReset );
-             _unlockPromise.set( true );
+            if( pending->reservation )
+                finish( *pending );
+            return;
         }
-        _workThread.join();
+
+        struct Executed
+        {
+            ~Executed()
+            {
+                const auto duration = std::chrono::steady_clock::now() - begin;
+                policy.onExecuted( executable, std::chrono::duration_cast<
+                                       std::chrono::nanoseconds >( duration ).count( ));
+            }
+
+            SchedulingPolicy& policy;
+            const Executable& executable;
+            const std::chrono::steady_clock::time_point begin;
+        } executed = { *policy, *pending->executable, std::chrono::steady_clock::now() };
+
+        createExecutable( pending )->execute();
+    }
+
+    ExecutablePtr createExecutable( const PendingExecutablePtr& pending );
+
+    void setSchedulingPolicy( const SchedulingPolicyPtr& policy )
+    {
+        WriteLock lock( _mutex );
+        _policy = policy;
+    }
+
+    SchedulingPolicyPtr getSchedulingPolicy()
+    {
+        ReadLock lock( _mutex );
+        return _policy;
+    }
+
+    void finish( const PendingExecutable& pending )
+    {
+        PendingExecutables ready;
+        _budget.finish( pending, ready );
+        for( const PendingExecutablePtr& readyPending: ready )
+            submit( readyPending );
+    }
+
+    void setMemoryBudget( const size_t budget )
+    {
+        PendingExecutables ready;
+        _budget.setBudget( budget, ready );
+        for( const PendingExecutablePtr& readyPending: ready )
+            submit( readyPending );
     }
 
-    void schedule()
+    std::unique_ptr< Workers > release()
     {
-        std::set< Future > inputConditions;
-        std::list< ExecutablePtr > executables;
-        while( true )
+        WriteLock lock( _mutex );
+        return std::move( _workers );
+    }
+
+    ReadWriteMutex _mutex;
+    std::unique_ptr< Workers > _workers;
+    std::atomic< size_t > _epoch;
+    MemoryBudget _budget;
+    SchedulingPolicyPtr _policy;
+
+    // Ordered by the rank of the policy, the equal ranks in the ready order
+    boost::mutex _readyMutex;
+    std::multimap< double, PendingExecutablePtr, std::greater< double >> _ready;
+};
+
+typedef std::shared_ptr< Dispatcher > DispatcherPtr;
+
+/** Returns the reserved memory of the executable inputs after the execution */
+class BudgetedExecutable : public Executable
+{
+public:
+
+    BudgetedExecutable( const PendingExecutablePtr& pending,
+                        const DispatcherPtr& dispatcher )
+        : _pending( pending )
+        , _dispatcher( dispatcher )
+    {}
+
+    void execute() final
+    {
+        struct Finish
         {
-            Futures futures = { Future( _unlockPromise ) };
-            futures.insert( futures.end(),
-                            inputConditions.begin(), inputConditions.end( ));
-            waitForAny( futures );
+            ~Finish() { dispatcher.finish( pending ); }
+            Dispatcher& dispatcher;
+            const PendingExecutable& pending;
+        } finish = { *_dispatcher, *_pending };
+
+        _pending->executable->execute();
+    }
+
+    std::string getName() const final
+    {
+        return _pending->executable->getName();
+    }
+
+    size_t getEstimatedOutputSize() const final
+    {
+        return _pending->executable->getEstimatedOutputSize();
+    }
+
+    int getPriority() const final
+    {
+        return _pending->executable->getPriority();
+    }
+
+    Futures getPostconditions() const final
+    {
+        return _pending->executable->getPostconditions();
+    }
+
+    Futures getPreconditions() const final
+    {
+        return _pending->executable->getPreconditions();
+    }
+
+    ExecutablePtr clone() const final
+    {
+        return _pending->executable->clone();
+    }
+
+private:
+
+    const PendingExecutablePtr _pending;
+    const DispatcherPtr _dispatcher;
+};
+
+void Dispatcher::submit( const PendingExecutablePtr& pending )
+{
+    {
+        ReadLock lock( _mutex );
+        if( _workers && pending->epoch == _epoch )
+        {
+            if( Trace::isEnabled( ))
+                Trace::instant( "executor", pending->executable->getName( ));
+
+            if( !_policy )
             {
-                ScopedLock lock( _promiseReset );
-                if( _unlockPromise.getFuture().isReady( ))
-                {
-                    while( !_mtWorkQueue.empty( ))
-                    {
-                        ExecutablePtr exec = _mtWorkQueue.pop();
-                        // In destruction tine "0" is pushed to the queue
-                        // and no further executable is scheduled
-                        if( !exec )
-                            return;
-
-                        executables.push_back( exec );
-                        const Futures& preConds = exec->getPreconditions();
-                        inputConditions.insert( preConds.begin(), preConds.end( ));
-                    }
-
-                    _unlockPromise.reset();
-                }
+                _workers->schedule( createExecutable( pending ));
+                return;
             }
 
-            std::list< ExecutablePtr >::iterator it = executables.begin();
-            while( it != executables.end( ))
+            const double rank = _policy->getRank( *pending->executable );
             {
-                ExecutablePtr executable = *it;
-                const Futures& preConds = executable->getPreconditions();
-                const FutureMap futureMap( preConds );
-                if( futureMap.isReady( ))
-                {
-                    _workers.schedule( executable );
-                    it = executables.erase( it );
-                    for( const auto& future: futureMap.getFutures( ))
-                        inputConditions.erase( future );
-                }
-                else
-                    ++it;
+                ScopedLock readyLock( _readyMutex );
+                _ready.emplace( rank, pending );
             }
+
+            const DispatcherPtr dispatcher = shared_from_this();
+            const SchedulingPolicyPtr policy = _policy;
+            _workers->submit( [ dispatcher, policy ]{ dispatcher->executeReady( policy ); });
+            return;
         }
     }
 
+    // The executables which are not executed return their reservation
+    if( pending->reservation )
+        finish( *pending );
+}
+
+ExecutablePtr Dispatcher::createExecutable( const PendingExecutablePtr& pending )
+{
+    if( pending->reservation )
+        return std::make_shared< BudgetedExecutable >( pending, shared_from_this( ));
+    return pending->executable;
+}
+
+}
+
+struct PushExecutor::Impl
+{
+    Impl( const size_t threadCount,
+          const std::string& threadPoolName,
+          const WorkerSetupFunc& setupFunc,
+          const Workers::QueueMode queueMode,
+          const Workers::Cores& cores )
+        : _dispatcher( new Dispatcher( threadCount, threadPoolName, setupFunc,
+                                       queueMode, cores ))
+    {}
+
+    ~Impl()
+    {
+        // Workers are joined outside of the dispatcher lock, as the executing
+        // filters may still dispatch their consumers.
+        std::unique_ptr< Workers > workers = _dispatcher->release();
+    }
+
     void clear()
     {
-        _mtWorkQueue.clear();
+        ++_dispatcher->_epoch;
+        _dispatcher->_budget.clear();
+
+        const SchedulingPolicyPtr policy = _dispatcher->getSchedulingPolicy();
+        if( policy )
+            policy->onCleared();
     }
 
-    void schedule( ExecutablePtr exec )
+    void schedule( const ExecutablePtr& exec )
     {
-        ScopedLock lock( _promiseReset );
-        const bool wasEmpty = _mtWorkQueue.empty();
-        _mtWorkQueue.pushFront( exec );
-        if( wasEmpty )
-            _unlockPromise.set( true );
+        const Futures& preConds = exec->getPreconditions();
+
+        // The additional count keeps the executable from being dispatched
+        // while the callbacks are registered.
+        const PendingExecutablePtr pending(
+                    new PendingExecutable( exec,
+                                           _dispatcher->_epoch,
+                                           preConds.size() + 1 ));
+        const DispatcherPtr dispatcher = _dispatcher;
+        if( dispatcher->_budget.isEnabled( ))
+            dispatcher->_budget.add( *pending, preConds );
+
+        const SchedulingPolicyPtr policy = dispatcher->getSchedulingPolicy();
+        if( policy )
+            policy->onScheduled( *exec );
+
+        for( const auto& future: preConds )
+        {
+            future.onReady( [ dispatcher, pending ]
+            {
+                if( pending->satisfy( ))
+                    dispatcher->dispatch( pending );
+            });
+        }
+
+        if( pending->satisfy( ))
+            dispatcher->dispatch( pending );
     }
 
-    MTQueue< ExecutablePtr > _mtWorkQueue;
-    Workers _workers;
-    Promise _unlockPromise;
-    boost::mutex _promiseReset;
-    boost::thread _workThread;
+    DispatcherPtr _dispatcher;
 };
 
 PushExecutor::PushExecutor( const size_t threadCount,
                                 const std::string& threadPoolName,
-                                const WorkerSetupFunc& setupFunc )
-    : _impl( new Impl( threadCount, threadPoolName, setupFunc ))
+                                const WorkerSetupFunc& setupFunc,
+                                const Workers::QueueMode queueMode,
+                                const Workers::Cores& cores )
+    : _impl( new Impl( threadCount, threadPoolName, setupFunc, queueMode, cores ))
 {
 }
 
@@ -149,6 +590,26 @@ void PushExecutor::clear()
     _impl->clear();
 }
 
+void PushExecutor::setSchedulingPolicy( SchedulingPolicyPtr policy )
+{
+    _impl->_dispatcher->setSchedulingPolicy( policy );
+}
+
+void PushExecutor::setMemoryBudget( const size_t bytes )
+{
+    _impl->_dispatcher->setMemoryBudget( bytes );
+}
+
+size_t PushExecutor::getMemoryBudget() const
+{
+    return _impl->_dispatcher->_budget.getBudget();
+}
+
+size_t PushExecutor::getReservedMemory() const
+{
+    return _impl->_dispatcher->_budget.getUsed();
+}
+
 void PushExecutor::schedule( ExecutablePtr executable )
 {
     _impl->schedule( executable );
@@ -23,6 +23,7 @@
 #include <tuyau/api.h>
 #include "executor.h"
 #include "types.h"
+#include "workers.h"
 
 namespace tuyau
 {
@@ -33,7 +34,8 @@ namespace tuyau
  * asynchronously.
  *
  * The submitted executables are scheduled to the worker threads,
- * by looking at the preconditions if they are satisfied.
+ * by looking at the preconditions if they are satisfied. The order of the
+ * ready executables can be set with a SchedulingPolicy.
  */
 class PushExecutor : public Executor
 {
@@ -44,10 +46,14 @@ public:
      * @param threadPoolName the threads are renamed with the given name
      * @param setupFunc setups the thread before running (i.e. setCurrent() with OpenGL)
      * the worker threads will share the context with the given context
+     * @param queueMode the distribution of the ready executables to the worker threads
+     * @param cores the worker threads are pinned to ( see Workers )
      */
     TUYAU_API PushExecutor( size_t threadCount,
                             const std::string& threadPoolName = "Simple Executor",
-                            const WorkerSetupFunc& setupFunc = WorkerSetupFunc( ));
+                            const WorkerSetupFunc& setupFunc = WorkerSetupFunc( ),
+                            Workers::QueueMode queueMode = Workers::SHARED_QUEUE,
+                            const Workers::Cores& cores = Workers::Cores( ));
 
     TUYAU_API virtual ~PushExecutor();
 
@@ -57,6 +63,40 @@ public:
     /** @copydoc Executor::clear */
     TUYAU_API void clear() final;
 
+    /**
+     * Sets the policy which orders the ready executables. Without a policy,
+     * the ready executables are passed to the worker queues as they become
+     * ready. With a policy, they are kept in a ready queue ordered by their
+     * ranks and each worker executes the highest ranked one.
+     * @copydoc Executor::setSchedulingPolicy
+     */
+    TUYAU_API void setSchedulingPolicy( SchedulingPolicyPtr policy ) final;
+
+    /**
+     * Limits the memory of the outputs of the executables in flight, which is
+     * estimated by Executable::getEstimatedOutputSize(). The estimated size
+     * of an executable is reserved when it is dispatched and returned when
+     * its consumers scheduled on the executor are finished ( or when it is
+     * finished if it has no consumers ). Ready executables which exceed the
+     * budget are deferred, preferring the ones which free more memory than
+     * they need. An executable is dispatched when no executable with a
+     * reservation is running, even if it exceeds the budget.
+     * The budget applies to the executables scheduled after it is set.
+     * @param bytes is the memory budget, 0 disables the limit
+     */
+    TUYAU_API void setMemoryBudget( size_t bytes );
+
+    /**
+     * @return the memory budget, 0 if there is no limit
+     */
+    TUYAU_API size_t getMemoryBudget() const;
+
+    /**
+     * @return the estimated output size of the executables, which are
+     * reserved from the memory budget
+     */
+    TUYAU_API size_t getReservedMemory() const;
+
 private:
 
     struct Impl;
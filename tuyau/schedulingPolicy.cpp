@@ -0,0 +1,367 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "schedulingPolicy.h"
+#include "executable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+
+namespace tuyau
+{
+
+void SchedulingPolicy::onScheduled( const Executable& )
+{}
+
+void SchedulingPolicy::onExecuted( const Executable&, uint64_t )
+{}
+
+void SchedulingPolicy::onCleared()
+{}
+
+double FifoPolicy::getRank( const Executable& )
+{
+    return 0;
+}
+
+double PriorityPolicy::getRank( const Executable& executable )
+{
+    return executable.getPriority();
+}
+
+namespace
+{
+
+// The relative move of a runtime, from the one the ranks are computed with,
+// which updates the ranks
+const double rankTolerance = 0.1;
+
+bool isMoved( const double rankRuntime, const double runtime )
+{
+    return std::abs( runtime - rankRuntime ) > rankTolerance * rankRuntime;
+}
+
+}
+
+struct CriticalPathPolicy::Impl
+{
+    /**
+     * A scheduled executable with its connections. The rank is valid for the
+     * rank version it is computed with, the visit marks the traversal which
+     * found it last. The upstream tasks of a task with an invalid rank have
+     * invalid ranks, too.
+     */
+    struct Task
+    {
+        std::string name;
+        std::vector< uint64_t > inputIds;
+        std::vector< uint64_t > outputIds;
+        double rank;
+        size_t rankVersion;
+        size_t visit;
+    };
+
+    typedef std::shared_ptr< Task > TaskPtr;
+
+    Impl()
+        : _runtimeSum( 0 )
+        , _rankAverage( 1 )
+        , _rankVersion( 1 )
+        , _visit( 0 )
+    {}
+
+    void onScheduled( const Executable& executable )
+    {
+        const TaskPtr task( new Task{ executable.getName(), {}, {}, 0, 0, 0 });
+        for( const auto& future: executable.getPreconditions( ))
+            task->inputIds.push_back( future.getId( ));
+        for( const auto& future: executable.getPostconditions( ))
+            task->outputIds.push_back( future.getId( ));
+
+        std::lock_guard< std::mutex > lock( _mutex );
+        for( const uint64_t id: task->inputIds )
+            _consumers[ id ].push_back( task );
+        for( const uint64_t id: task->outputIds )
+            _producers[ id ] = task;
+        _namedTasks[ task->name ].push_back( task );
+        _tasks[ &executable ] = task;
+
+        // The producers have a new downstream path
+        invalidateProducers( *task );
+    }
+
+    double getRank( const Executable& executable )
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        const auto it = _tasks.find( &executable );
+        if( it == _tasks.end( ))
+            return getEstimatedRuntime( executable.getName( ));
+
+        return computeRank( it->second );
+    }
+
+    /**
+     * Computes the ranks of the task and its downstream tasks in post order.
+     * The valid ranks are kept, so only the downstream tasks, which are
+     * scheduled or whose runtimes moved since the last ranking, are visited.
+     */
+    double computeRank( const TaskPtr& root )
+    {
+        const size_t visit = ++_visit;
+        std::vector< TaskPtr > stack( 1, root );
+        while( !stack.empty( ))
+        {
+            const TaskPtr task = stack.back();
+            if( task->rankVersion == _rankVersion )
+            {
+                stack.pop_back();
+                continue;
+            }
+
+            if( task->visit != visit )
+            {
+                task->visit = visit;
+                for( const uint64_t id: task->outputIds )
+                {
+                    const auto it = _consumers.find( id );
+                    if( it == _consumers.end( ))
+                        continue;
+
+                    for( const TaskPtr& consumer: it->second )
+                    {
+                        // The visited ones which are not ranked are in a cycle
+                        if( consumer->visit != visit )
+                            stack.push_back( consumer );
+                    }
+                }
+                continue;
+            }
+
+            double downstream = 0;
+            for( const uint64_t id: task->outputIds )
+            {
+                const auto it = _consumers.find( id );
+                if( it == _consumers.end( ))
+                    continue;
+
+                for( const TaskPtr& consumer: it->second )
+                    downstream = std::max( downstream, consumer->rank );
+            }
+
+            task->rank = getEstimatedRuntime( task->name ) + downstream;
+            task->rankVersion = _rankVersion;
+            stack.pop_back();
+        }
+        return root->rank;
+    }
+
+    /** Invalidates the ranks of the task and its upstream tasks */
+    void invalidate( const TaskPtr& task )
+    {
+        std::vector< TaskPtr > stack( 1, task );
+        while( !stack.empty( ))
+        {
+            const TaskPtr current = stack.back();
+            stack.pop_back();
+
+            // The upstream tasks of an invalid rank are invalid already
+            if( current->rankVersion != _rankVersion )
+                continue;
+
+            current->rankVersion = 0;
+            for( const uint64_t id: current->inputIds )
+            {
+                const auto it = _producers.find( id );
+                if( it != _producers.end( ))
+                    stack.push_back( it->second );
+            }
+        }
+    }
+
+    void invalidateProducers( const Task& task )
+    {
+        for( const uint64_t id: task.inputIds )
+        {
+            const auto it = _producers.find( id );
+            if( it != _producers.end( ))
+                invalidate( it->second );
+        }
+    }
+
+    /**
+     * Updates the runtimes the ranks are computed with, when the runtime of
+     * the executable or the average runtime moved by more than the tolerance.
+     * Otherwise the ranks of a long graph would be computed again after every
+     * execution, for the small moves of the averages.
+     */
+    void updateRankRuntimes( const std::string& name, const double runtime )
+    {
+        const double average = _runtimeSum / _runtimes.size();
+        if( isMoved( _rankAverage, average ))
+        {
+            _rankAverage = average;
+            ++_rankVersion;
+        }
+
+        const auto it = _rankRuntimes.find( name );
+        if( !isMoved( it == _rankRuntimes.end() ? _rankAverage : it->second, runtime ))
+            return;
+
+        _rankRuntimes[ name ] = runtime;
+        const auto tasks = _namedTasks.find( name );
+        if( tasks == _namedTasks.end( ))
+            return;
+
+        for( const TaskPtr& task: tasks->second )
+            invalidate( task );
+    }
+
+    void onExecuted( const Executable& executable, const uint64_t duration )
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        const std::string& name = executable.getName();
+        if( !name.empty( ))
+        {
+            const auto it = _runtimes.find( name );
+            if( it == _runtimes.end( ))
+            {
+                _runtimes[ name ] = duration;
+                _runtimeSum += duration;
+                updateRankRuntimes( name, duration );
+            }
+            else
+            {
+                // Exponential moving average of the execution times
+                const double runtime = it->second + ( duration - it->second ) / 4;
+                _runtimeSum += runtime - it->second;
+                it->second = runtime;
+                updateRankRuntimes( name, runtime );
+            }
+        }
+
+        const auto it = _tasks.find( &executable );
+        if( it == _tasks.end( ))
+            return;
+
+        const TaskPtr task = it->second;
+        _tasks.erase( it );
+        invalidateProducers( *task );
+        for( const uint64_t id: task->inputIds )
+        {
+            const auto consumers = _consumers.find( id );
+            if( consumers == _consumers.end( ))
+                continue;
+
+            std::vector< TaskPtr >& tasks = consumers->second;
+            tasks.erase( std::remove( tasks.begin(), tasks.end(), task ), tasks.end( ));
+            if( tasks.empty( ))
+                _consumers.erase( consumers );
+        }
+
+        for( const uint64_t id: task->outputIds )
+        {
+            const auto producer = _producers.find( id );
+            if( producer != _producers.end() && producer->second == task )
+                _producers.erase( producer );
+        }
+
+        std::vector< TaskPtr >& namedTasks = _namedTasks[ task->name ];
+        namedTasks.erase( std::remove( namedTasks.begin(), namedTasks.end(), task ),
+                          namedTasks.end( ));
+        if( namedTasks.empty( ))
+            _namedTasks.erase( task->name );
+    }
+
+    /** The runtimes are kept for the next executions */
+    void onCleared()
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        _tasks.clear();
+        _consumers.clear();
+        _producers.clear();
+        _namedTasks.clear();
+    }
+
+    double getRuntime( const std::string& name ) const
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        const auto it = _runtimes.find( name );
+        return it == _runtimes.end() ? 0 : it->second;
+    }
+
+    /** @return the runtime the ranks are computed with */
+    double getEstimatedRuntime( const std::string& name ) const
+    {
+        const auto it = _rankRuntimes.find( name );
+        return it == _rankRuntimes.end() ? _rankAverage : it->second;
+    }
+
+    mutable std::mutex _mutex;
+    std::unordered_map< const Executable*, TaskPtr > _tasks;
+    std::unordered_map< uint64_t, std::vector< TaskPtr >> _consumers; // By input
+    std::unordered_map< uint64_t, TaskPtr > _producers; // By output
+    std::unordered_map< std::string, std::vector< TaskPtr >> _namedTasks;
+    std::unordered_map< std::string, double > _runtimes;
+    double _runtimeSum;
+
+    // The runtimes the ranks are computed with, the executables without one
+    // count with the average
+    std::unordered_map< std::string, double > _rankRuntimes;
+    double _rankAverage;
+    size_t _rankVersion; // Invalidates all the ranks when incremented
+    size_t _visit;
+};
+
+CriticalPathPolicy::CriticalPathPolicy()
+    : _impl( new Impl )
+{}
+
+CriticalPathPolicy::~CriticalPathPolicy()
+{}
+
+void CriticalPathPolicy::onScheduled( const Executable& executable )
+{
+    _impl->onScheduled( executable );
+}
+
+double CriticalPathPolicy::getRank( const Executable& executable )
+{
+    return _impl->getRank( executable );
+}
+
+void CriticalPathPolicy::onExecuted( const Executable& executable,
+                                     const uint64_t duration )
+{
+    _impl->onExecuted( executable, duration );
+}
+
+void CriticalPathPolicy::onCleared()
+{
+    _impl->onCleared();
+}
+
+double CriticalPathPolicy::getRuntime( const std::string& name ) const
+{
+    return _impl->getRuntime( name );
+}
+
+}
@@ -0,0 +1,140 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef _SchedulingPolicy_h_
+#define _SchedulingPolicy_h_
+
+#include <tuyau/api.h>
+#include "types.h"
+
+namespace tuyau
+{
+
+/**
+ * Orders the ready executables of an executor ( see
+ * Executor::setSchedulingPolicy() ). The executables with higher ranks are
+ * executed first and the ones with equal ranks in the order they become
+ * ready. The functions are called from multiple threads, so the
+ * implementations have to be thread safe.
+ */
+class SchedulingPolicy
+{
+public:
+
+    TUYAU_API virtual ~SchedulingPolicy() {}
+
+    /**
+     * Is called when the executable is scheduled, before it is ready.
+     * @param executable is the scheduled executable
+     */
+    TUYAU_API virtual void onScheduled( const Executable& executable );
+
+    /**
+     * @param executable is the ready executable
+     * @return the rank of the executable
+     */
+    virtual double getRank( const Executable& executable ) = 0;
+
+    /**
+     * Is called after the executable is executed.
+     * @param executable is the executed executable
+     * @param duration is the execution time in nanoseconds
+     */
+    TUYAU_API virtual void onExecuted( const Executable& executable,
+                                       uint64_t duration );
+
+    /**
+     * Is called when the executor is cleared ( see Executor::clear() ), the
+     * scheduled executables, which are not executed yet, are not executed.
+     */
+    TUYAU_API virtual void onCleared();
+};
+
+/**
+ * Executes the ready executables in the order they become ready.
+ */
+class FifoPolicy : public SchedulingPolicy
+{
+public:
+
+    /** @copydoc SchedulingPolicy::getRank */
+    TUYAU_API double getRank( const Executable& executable ) final;
+};
+
+/**
+ * Executes the ready executables with higher priorities first ( see
+ * PipeFilter::setPriority() ).
+ */
+class PriorityPolicy : public SchedulingPolicy
+{
+public:
+
+    /** @copydoc SchedulingPolicy::getRank */
+    TUYAU_API double getRank( const Executable& executable ) final;
+};
+
+/**
+ * Executes the ready executables with the longest remaining downstream path
+ * first, which shortens the total execution time of graphs with long chains.
+ * The path length is the sum of the execution times of the executables on
+ * the path, which are averaged over the previous executions of the
+ * executables with the same name. The executables without history count with
+ * the average execution time. The graph is built from the connections of the
+ * scheduled executables, so the executables should be scheduled before their
+ * producers are ready. The ranks are kept until an execution time moves by
+ * more than 10% from the one they are computed with, then the ranks upstream
+ * of the executables with that name are computed again.
+ */
+class CriticalPathPolicy : public SchedulingPolicy
+{
+public:
+
+    TUYAU_API CriticalPathPolicy();
+    TUYAU_API ~CriticalPathPolicy();
+
+    /** @copydoc SchedulingPolicy::onScheduled */
+    TUYAU_API void onScheduled( const Executable& executable ) final;
+
+    /** @copydoc SchedulingPolicy::getRank */
+    TUYAU_API double getRank( const Executable& executable ) final;
+
+    /** @copydoc SchedulingPolicy::onExecuted */
+    TUYAU_API void onExecuted( const Executable& executable,
+                               uint64_t duration ) final;
+
+    /** @copydoc SchedulingPolicy::onCleared */
+    TUYAU_API void onCleared() final;
+
+    /**
+     * @param name of the executable
+     * @return the average execution time in nanoseconds of the executables
+     * with the given name, 0 if there is no history
+     */
+    TUYAU_API double getRuntime( const std::string& name ) const;
+
+private:
+
+    struct Impl;
+    std::unique_ptr< Impl > _impl;
+};
+
+}
+
+#endif // _SchedulingPolicy_h_
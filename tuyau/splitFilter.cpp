@@ -0,0 +1,86 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "splitFilter.h"
+#include "parallel.h"
+#include "workers.h"
+
+#include <algorithm>
+
+namespace tuyau
+{
+
+namespace
+{
+
+Futures getFutures( const Promises& promises )
+{
+    Futures futures;
+    for( const auto& promise: promises )
+        futures.push_back( promise.getFuture( ));
+    return futures;
+}
+
+}
+
+void SplitFilter::execute( const FutureMap& input, PromiseMap& output ) const
+{
+    const Workers* workers = Workers::getCurrent();
+    const size_t nChunks = std::max( split( input, workers ? workers->getSize() : 1 ),
+                                     size_t( 1 ));
+
+    const DataInfos dataInfos = getChunkDataInfos();
+    std::vector< Promises > chunkPromises( nChunks );
+    for( Promises& promises: chunkPromises )
+    {
+        for( const auto& dataInfo: dataInfos )
+            promises.push_back( Promise( dataInfo ));
+    }
+
+    // Each chunk is an iteration of the parallel loop, out of the worker
+    // threads they are executed one after the other
+    parallelFor( 0, nChunks, [ & ]( const size_t first, const size_t last )
+    {
+        for( size_t chunk = first; chunk < last; ++chunk )
+        {
+            PromiseMap chunkOutput( chunkPromises[ chunk ]);
+            executeChunk( input, chunk, nChunks, chunkOutput );
+            chunkOutput.flush();
+        }
+    }, 1 );
+
+    std::vector< FutureMap > chunkOutputs;
+    chunkOutputs.reserve( nChunks );
+    for( const Promises& promises: chunkPromises )
+        chunkOutputs.emplace_back( getFutures( promises ));
+    merge( input, chunkOutputs, output );
+}
+
+size_t SplitFilter::split( const FutureMap&, const size_t maxChunks ) const
+{
+    return maxChunks;
+}
+
+DataInfos SplitFilter::getChunkDataInfos() const
+{
+    return getOutputDataInfos();
+}
+
+}
@@ -0,0 +1,98 @@
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef _SplitFilter_h_
+#define _SplitFilter_h_
+
+#include <tuyau/api.h>
+
+#include "filter.h"
+
+namespace tuyau
+{
+
+/**
+ * Base class for the data parallel filters, whose execution can be split into
+ * chunks, i.e. the slabs of a volume. The chunks are executed concurrently on
+ * the workers running the filter and their outputs are merged into the
+ * outputs of the filter. The number of chunks follows the number of threads
+ * of the workers. Out of the worker threads, i.e. in Pipeline::execute(), the
+ * chunks are executed one after the other.
+ *
+ * The chunks are executed with parallelFor(), so the worker thread of the
+ * filter executes chunks, too.
+ */
+class SplitFilter : public Filter
+{
+public:
+
+    /**
+     * Splits the execution, executes the chunks and merges their outputs.
+     * @copydoc Filter::execute
+     * @throw the first exception thrown by the chunks, after all chunks are
+     * finished
+     */
+    TUYAU_API void execute( const FutureMap& input, PromiseMap& output ) const final;
+
+protected:
+
+    /**
+     * The splitter of the execution.
+     * @param input is the input of the execution
+     * @param maxChunks is the number of threads of the workers running the
+     * execution, 1 out of the worker threads
+     * @return the number of chunks, maxChunks by default. A chunk is executed
+     * if 0 is returned.
+     */
+    TUYAU_API virtual size_t split( const FutureMap& input, size_t maxChunks ) const;
+
+    /**
+     * @return the names and the data types of the outputs of a chunk, the
+     * outputs of the filter by default
+     */
+    TUYAU_API virtual DataInfos getChunkDataInfos() const;
+
+    /**
+     * Executes a chunk. The chunks are executed concurrently.
+     * @param input is the input of the execution
+     * @param chunk is the index of the chunk
+     * @param nChunks is the number of the chunks
+     * @param output is the output of the chunk ( see getChunkDataInfos() ),
+     * the outputs which are not set are flushed.
+     */
+    virtual void executeChunk( const FutureMap& input,
+                               size_t chunk,
+                               size_t nChunks,
+                               PromiseMap& output ) const = 0;
+
+    /**
+     * The merger of the outputs of the chunks.
+     * @param input is the input of the execution
+     * @param chunks are the outputs of the chunks in the chunk order
+     * @param output is the output of the filter
+     */
+    virtual void merge( const FutureMap& input,
+                        const std::vector< FutureMap >& chunks,
+                        PromiseMap& output ) const = 0;
+};
+
+}
+
+#endif // _SplitFilter_h_
@@ -0,0 +1,296 @@
+
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <ostream>
+
+namespace tuyau
+{
+
+namespace
+{
+
+const size_t MAX_EVENTS_PER_THREAD = 16384;
+const size_t MAX_NAME_LENGTH = 63;
+
+const auto clockEpoch = std::chrono::steady_clock::now();
+
+struct Event
+{
+    char phase;
+    const char* category;
+    char name[ MAX_NAME_LENGTH + 1 ];
+    uint64_t begin;
+    uint64_t end;
+};
+
+/**
+ * Events of a thread. Only the owner thread appends events and publishes them
+ * with the release store of the count, so the writer reads the published
+ * events without locking.
+ */
+struct ThreadBuffer
+{
+    ThreadBuffer( const size_t id_, const std::string& threadName_ )
+        : id( id_ )
+        , threadName( threadName_ )
+        , events( new Event[ MAX_EVENTS_PER_THREAD ])
+        , count( 0 )
+        , dropped( 0 )
+        , finished( false )
+    {}
+
+    void append( const char phase,
+                 const char* category,
+                 const std::string& name,
+                 const uint64_t begin,
+                 const uint64_t end )
+    {
+        const size_t index = count.load( std::memory_order_relaxed );
+        if( index == MAX_EVENTS_PER_THREAD )
+        {
+            dropped.fetch_add( 1, std::memory_order_relaxed );
+            return;
+        }
+
+        Event& event = events[ index ];
+        event.phase = phase;
+        event.category = category;
+        const size_t length = std::min( name.size(), MAX_NAME_LENGTH );
+        std::memcpy( event.name, name.data(), length );
+        event.name[ length ] = '\0';
+        event.begin = begin;
+        event.end = end;
+        count.store( index + 1, std::memory_order_release );
+    }
+
+    const size_t id;
+    std::string threadName; // Protected by the registry mutex
+    const std::unique_ptr< Event[] > events;
+    std::atomic< size_t > count;
+    std::atomic< size_t > dropped;
+    std::atomic< bool > finished;
+};
+
+typedef std::shared_ptr< ThreadBuffer > ThreadBufferPtr;
+
+struct Registry
+{
+    Registry()
+        : nextId( 1 )
+    {}
+
+    std::mutex mutex;
+    std::vector< ThreadBufferPtr > buffers;
+    size_t nextId;
+};
+
+Registry& getRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+/** Registers the buffer of the thread on first use and marks it on exit */
+struct ThreadState
+{
+    ~ThreadState()
+    {
+        if( buffer )
+            buffer->finished = true;
+    }
+
+    ThreadBuffer& getBuffer()
+    {
+        if( !buffer )
+        {
+            Registry& registry = getRegistry();
+            std::lock_guard< std::mutex > lock( registry.mutex );
+            buffer = std::make_shared< ThreadBuffer >( registry.nextId++, threadName );
+            registry.buffers.push_back( buffer );
+        }
+        return *buffer;
+    }
+
+    std::string threadName;
+    ThreadBufferPtr buffer;
+};
+
+thread_local ThreadState threadState;
+
+void writeString( std::ostream& os, const char* string )
+{
+    os << '"';
+    for( const char* c = string; *c; ++c )
+    {
+        switch( *c )
+        {
+        case '"':  os << "\\\""; break;
+        case '\\': os << "\\\\"; break;
+        case '\n': os << "\\n"; break;
+        case '\t': os << "\\t"; break;
+        default:
+            if( static_cast< unsigned char >( *c ) < 0x20 )
+                os << ' ';
+            else
+                os << *c;
+        }
+    }
+    os << '"';
+}
+
+void writeTime( std::ostream& os, const uint64_t nanoseconds )
+{
+    os << nanoseconds / 1000 << '.';
+    const uint64_t fraction = nanoseconds % 1000;
+    if( fraction < 100 )
+        os << '0';
+    if( fraction < 10 )
+        os << '0';
+    os << fraction;
+}
+
+}
+
+std::atomic< bool > Trace::_enabled( false );
+
+void Trace::enable()
+{
+    _enabled = true;
+}
+
+void Trace::disable()
+{
+    _enabled = false;
+}
+
+void Trace::clear()
+{
+    Registry& registry = getRegistry();
+    std::lock_guard< std::mutex > lock( registry.mutex );
+
+    std::vector< ThreadBufferPtr > buffers;
+    for( const ThreadBufferPtr& buffer: registry.buffers )
+    {
+        if( buffer->finished )
+            continue;
+
+        buffer->count = 0;
+        buffer->dropped = 0;
+        buffers.push_back( buffer );
+    }
+    registry.buffers.swap( buffers );
+}
+
+void Trace::write( std::ostream& os )
+{
+    Registry& registry = getRegistry();
+    std::lock_guard< std::mutex > lock( registry.mutex );
+
+    os << "{\"traceEvents\":[";
+    bool first = true;
+    for( const ThreadBufferPtr& buffer: registry.buffers )
+    {
+        if( !buffer->threadName.empty( ))
+        {
+            os << ( first ? "\n" : ",\n" )
+               << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"
+               << buffer->id << ",\"args\":{\"name\":";
+            writeString( os, buffer->threadName.c_str( ));
+            os << "}}";
+            first = false;
+        }
+
+        const size_t count = buffer->count.load( std::memory_order_acquire );
+        for( size_t i = 0; i < count; ++i )
+        {
+            const Event& event = buffer->events[ i ];
+            os << ( first ? "\n" : ",\n" ) << "{\"ph\":\"" << event.phase
+               << "\",\"cat\":";
+            writeString( os, event.category );
+            os << ",\"name\":";
+            writeString( os, event.name );
+            os << ",\"pid\":1,\"tid\":" << buffer->id << ",\"ts\":";
+            writeTime( os, event.begin );
+            if( event.phase == 'X' )
+            {
+                os << ",\"dur\":";
+                writeTime( os, event.end - event.begin );
+            }
+            else
+                os << ",\"s\":\"t\"";
+            os << "}";
+            first = false;
+        }
+    }
+    os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+size_t Trace::getDroppedCount()
+{
+    Registry& registry = getRegistry();
+    std::lock_guard< std::mutex > lock( registry.mutex );
+
+    size_t dropped = 0;
+    for( const ThreadBufferPtr& buffer: registry.buffers )
+        dropped += buffer->dropped;
+    return dropped;
+}
+
+uint64_t Trace::now()
+{
+    return std::chrono::duration_cast< std::chrono::nanoseconds >(
+                std::chrono::steady_clock::now() - clockEpoch ).count();
+}
+
+void Trace::complete( const char* category,
+                      const std::string& name,
+                      const uint64_t begin,
+                      const uint64_t end )
+{
+    if( isEnabled( ))
+        threadState.getBuffer().append( 'X', category, name, begin, end );
+}
+
+void Trace::instant( const char* category, const std::string& name )
+{
+    if( isEnabled( ))
+    {
+        const uint64_t time = now();
+        threadState.getBuffer().append( 'i', category, name, time, time );
+    }
+}
+
+void Trace::setThreadName( const std::string& name )
+{
+    threadState.threadName = name;
+    if( threadState.buffer )
+    {
+        std::lock_guard< std::mutex > lock( getRegistry().mutex );
+        threadState.buffer->threadName = name;
+    }
+}
+
+}
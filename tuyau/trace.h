@@ -0,0 +1,145 @@
+
+/* Copyright (c) 2011-2016, EPFL/Blue Brain Project
+ *                     Ahmet Bilgili <ahmet.bilgili@epfl.ch>
+ *
+ * This file is part of Tuyau <https://github.com/bilgili/Tuyau>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _Trace_h_
+#define _Trace_h_
+
+#include <tuyau/api.h>
+#include "types.h"
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+
+namespace tuyau
+{
+
+/**
+ * Opt-in execution tracing. When enabled, the pipe filter executions, the
+ * time the executables wait in the worker queues, the dispatch of ready
+ * executables and the port updates are recorded into per-thread buffers. The
+ * recorded events are written as Chrome trace event JSON, which can be opened
+ * with chrome://tracing or Perfetto.
+ *
+ * When tracing is disabled, the instrumentation costs a relaxed atomic load.
+ */
+class Trace
+{
+public:
+
+    /** Starts recording the events */
+    TUYAU_API static void enable();
+
+    /** Stops recording the events, the recorded events are kept */
+    TUYAU_API static void disable();
+
+    /** @return true if the events are recorded */
+    static bool isEnabled() { return _enabled.load( std::memory_order_relaxed ); }
+
+    /**
+     * Removes the recorded events. It should be called while no events are
+     * recorded ( i.e. the tracing is disabled ).
+     */
+    TUYAU_API static void clear();
+
+    /**
+     * Writes the recorded events as Chrome trace event JSON. It can be called
+     * while the events are recorded.
+     * @param os is the output stream
+     */
+    TUYAU_API static void write( std::ostream& os );
+
+    /**
+     * @return the number of events which are not recorded because the buffer
+     * of their thread was full.
+     */
+    TUYAU_API static size_t getDroppedCount();
+
+    /** @return the current time of the trace clock in nanoseconds */
+    TUYAU_API static uint64_t now();
+
+    /**
+     * Records an event with a duration, if tracing is enabled.
+     * @param category of the event, which has to be a string literal
+     * @param name of the event
+     * @param begin is the start time of the event ( see now() )
+     * @param end is the end time of the event ( see now() )
+     */
+    TUYAU_API static void complete( const char* category,
+                                    const std::string& name,
+                                    uint64_t begin,
+                                    uint64_t end );
+
+    /**
+     * Records an event without duration, if tracing is enabled.
+     * @param category of the event, which has to be a string literal
+     * @param name of the event
+     */
+    TUYAU_API static void instant( const char* category,
+                                   const std::string& name );
+
+    /**
+     * Names the current thread in the trace.
+     * @param name of the thread
+     */
+    TUYAU_API static void setThreadName( const std::string& name );
+
+private:
+
+    TUYAU_API static std::atomic< bool > _enabled;
+};
+
+/**
+ * Records the lifetime of the scope as a complete event, if tracing is enabled
+ * at construction.
+ */
+class TraceScope
+{
+public:
+
+    /**
+     * @param category of the event, which has to be a string literal
+     * @param name of the event, which is referenced until the scope ends
+     */
+    TraceScope( const char* category, const std::string& name )
+        : _category( Trace::isEnabled() ? category : nullptr )
+        , _name( name )
+        , _begin( _category ? Trace::now() : 0 )
+    {}
+
+    ~TraceScope()
+    {
+        if( _category )
+            Trace::complete( _category, _name, _begin, Trace::now( ));
+    }
+
+private:
+
+    TraceScope( const TraceScope& ) = delete;
+    TraceScope& operator=( const TraceScope& ) = delete;
+
+    const char* const _category;
+    const std::string& _name;
+    const uint64_t _begin;
+};
+
+}
+
+#endif // _Trace_h_
@@ -30,11 +30,13 @@ class OutputPort;
 class UniqueFutureMap;
 class Pipeline;
 class PipeFilter;
+class SchedulingPolicy;
 class Workers;
 
 typedef std::shared_ptr< PortData > PortDataPtr;
 typedef std::shared_ptr< Executable > ExecutablePtr;
 typedef std::unique_ptr< Filter > FilterPtr;
+typedef std::shared_ptr< SchedulingPolicy > SchedulingPolicyPtr;
 
 typedef std::list< Executable* > Executables;
 typedef std::list< Future > Futures;
@@ -51,6 +53,21 @@ typedef std::map< std::string, std::type_index > DataInfos;
 typedef std::map< std::string, PipeFilter > PipeFilterMap;
 typedef DataInfos::value_type DataInfo;
 
+/**
+ * Compiled reference to a filter port. The handles are resolved once from the
+ * port names ( see Filter::getInputHandle() and Filter::getOutputHandle() ),
+ * so that the ports are accessed by index at execution time.
+ */
+struct PortHandle
+{
+    explicit PortHandle( const size_t index_ = 0 )
+        : index( index_ )
+    {}
+
+    /** The position of the port in the name ordered port list */
+    size_t index;
+};
+
 /** Locking object definitions */
 typedef boost::shared_mutex ReadWriteMutex;
 typedef boost::shared_lock< ReadWriteMutex > ReadLock;
@@ -59,6 +76,11 @@ typedef boost::unique_lock< boost::mutex > ScopedLock;
 
 typedef std::function<void()> WorkerSetupFunc;
 typedef std::function<void()> WorkerDestroyFunc;
+typedef std::function<void()> ReadyCallback;
+typedef std::function<void( const Future& )> ContinuationFunc;
+typedef std::function<void()> WorkerTask;
+typedef std::function<void( const WorkerTask& )> AsyncStartFunc;
+typedef std::function<void( size_t, size_t )> RangeFunc;
 
 }
 #endif // _tuyau_types_h_
@@ -18,59 +18,839 @@
  */
 
 #include "workers.h"
+#include "blockPool.h"
 #include "executable.h"
+#include "mpmcQueue.h"
 #include "mtQueue.h"
+#include "trace.h"
 
+#include <boost/context/fiber.hpp>
+#include <boost/context/protected_fixedsize_stack.hpp>
 #include <boost/thread/thread.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
 namespace tuyau
 {
 
+namespace
+{
+
+/**
+ * The queue where the workers retrieve the executables from. pop() blocks
+ * until an executable is available or the queue is stopped. On stop, an
+ * empty executable is returned after all the queued executables are popped.
+ */
+class WorkQueue
+{
+public:
+    virtual ~WorkQueue() {}
+    virtual void push( const ExecutablePtr& executable ) = 0;
+    virtual ExecutablePtr pop( size_t threadIndex ) = 0;
+    virtual void stop() = 0;
+};
+
+/** The worker queue of the current thread, if the thread is a worker */
+struct CurrentWorker
+{
+    Workers* workers;
+    const WorkQueue* queue;
+    size_t threadIndex;
+    size_t stack; //!< The thread whose stack runs the loop, fiberStack in fibers
+    bool stopped; //!< The queue is stopped for the thread
+};
+
+const size_t fiberStack = std::numeric_limits< size_t >::max();
+
+// The executables may resume on another thread after an await. Within a
+// function, the compilers assume that the thread does not change, so they may
+// reuse the address of a thread local variable computed before a call, or
+// merge the calls of a function they consider pure. Hence the thread local
+// state is only accessed through accessors, which are not inlined and have a
+// side effect for the optimizer ( the barrier ), and a reference returned by
+// an accessor is not used after a call which may switch the context
+// ( Workers::await(), Executable::execute( )), the accessor is called again.
+// testAwaitThreadState checks the state after the executables migrate.
+#ifdef __GNUC__
+#  define TUYAU_THREAD_LOCAL_ACCESSOR __attribute__(( noinline ))
+#  define TUYAU_THREAD_LOCAL_BARRIER asm volatile( "" ::: "memory" )
+#else
+#  define TUYAU_THREAD_LOCAL_ACCESSOR __declspec( noinline )
+#  define TUYAU_THREAD_LOCAL_BARRIER
+#endif
+
+TUYAU_THREAD_LOCAL_ACCESSOR CurrentWorker& getCurrentWorker()
+{
+    static thread_local CurrentWorker currentWorker = { nullptr, nullptr, 0,
+                                                        fiberStack, false };
+    TUYAU_THREAD_LOCAL_BARRIER;
+    return currentWorker;
+}
+
+namespace ctx = boost::context;
+
+/** The state of an executable suspended by Workers::await() */
+struct AwaitState
+{
+    explicit AwaitState( const AsyncStartFunc& start_ )
+        : start( start_ )
+        , resumed( false )
+    {}
+
+    const AsyncStartFunc start;
+    ctx::fiber fiber;
+    std::exception_ptr exception;
+    std::atomic< bool > resumed;
+};
+
+typedef std::shared_ptr< AwaitState > AwaitStatePtr;
+
+/**
+ * The contexts running the loops of the worker threads. A thread runs its
+ * loop on its own stack until an executable awaits. The awaiting context is
+ * suspended and the thread continues its loop in another context: its own
+ * stack if it is free, an idle fiber, or a new fiber, so the fibers are only
+ * allocated when the executables await. An executable resumes on the thread
+ * which executes its resume executable, and the context of that thread is
+ * suspended until a thread takes it to continue its loop. The stack of a
+ * thread may run on the other threads, but only its thread takes it back, and
+ * the loop finishes on it when the queue stops.
+ */
+class LoopContexts
+{
+public:
+
+    /**
+     * @param nThreads the number of worker threads
+     * @param fiberStackSize the stack size of the fibers
+     * @param loop runs the loop of the current thread in a fiber until the
+     * queue stops
+     */
+    LoopContexts( const size_t nThreads,
+                  const size_t fiberStackSize,
+                  const std::function< void() >& loop )
+        : _fiberStackSize( fiberStackSize )
+        , _loop( loop )
+        , _threadStacks( nThreads )
+    {}
+
+    /**
+     * Suspends the current context until the await is over, the thread
+     * continues its loop in another context. The operation starts after the
+     * switch, so its completion can resume the context from any thread.
+     * @param await the suspended executable
+     * @param resume resumes the executable when the operation completes
+     */
+    void await( const AwaitStatePtr& await, const WorkerTask& resume )
+    {
+        switchTo( takeContext(), [ await, resume ]( ctx::fiber&& suspended )
+        {
+            await->fiber = std::move( suspended );
+            try
+            {
+                await->start( resume );
+            }
+            catch( ... )
+            {
+                await->exception = std::current_exception();
+                resume();
+            }
+        });
+    }
+
+    /** Switches to the awaiting context, the current context is suspended */
+    void resume( const AwaitStatePtr& await )
+    {
+        const size_t stack = getCurrentWorker().stack;
+        switchTo( std::move( await->fiber ), [ this, stack ]( ctx::fiber&& suspended )
+        {
+            suspend( std::move( suspended ), stack );
+        });
+    }
+
+    /** Suspends the current context, the thread continues its loop in another */
+    void yield()
+    {
+        const size_t stack = getCurrentWorker().stack;
+        switchTo( takeContext(), [ this, stack ]( ctx::fiber&& suspended )
+        {
+            suspend( std::move( suspended ), stack );
+        });
+    }
+
+    /** @return the stack of the thread, once it is suspended */
+    ctx::fiber takeThreadStack( const size_t threadIndex )
+    {
+        std::unique_lock< std::mutex > lock( _mutex );
+        _suspended.wait( lock, [ & ]{ return bool( _threadStacks[ threadIndex ]); });
+        return std::move( _threadStacks[ threadIndex ]);
+    }
+
+private:
+
+    /**
+     * Switches to the context, which first calls fn with the suspended one.
+     * Returns when the current context is resumed, possibly on another thread.
+     */
+    template< typename F >
+    void switchTo( ctx::fiber&& context, const F& fn )
+    {
+        const size_t stack = getCurrentWorker().stack;
+        std::move( context ).resume_with( [ fn ]( ctx::fiber&& suspended )
+        {
+            fn( std::move( suspended ));
+            return ctx::fiber();
+        });
+        getCurrentWorker().stack = stack;
+    }
+
+    /** @return the context to continue the loop of the current thread in */
+    ctx::fiber takeContext()
+    {
+        const size_t threadIndex = getCurrentWorker().threadIndex;
+        {
+            std::lock_guard< std::mutex > lock( _mutex );
+            if( _threadStacks[ threadIndex ])
+                return std::move( _threadStacks[ threadIndex ]);
+
+            if( !_idleFibers.empty( ))
+            {
+                ctx::fiber fiber = std::move( _idleFibers.back( ));
+                _idleFibers.pop_back();
+                return fiber;
+            }
+        }
+
+        return ctx::fiber( std::allocator_arg,
+                           ctx::protected_fixedsize_stack( _fiberStackSize ),
+                           [ this ]( ctx::fiber&& )
+        {
+            getCurrentWorker().stack = fiberStack;
+            _loop();
+            return takeThreadStack( getCurrentWorker().threadIndex );
+        });
+    }
+
+    void suspend( ctx::fiber&& context, const size_t stack )
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        if( stack == fiberStack )
+            _idleFibers.push_back( std::move( context ));
+        else
+        {
+            _threadStacks[ stack ] = std::move( context );
+            _suspended.notify_all();
+        }
+    }
+
+    const size_t _fiberStackSize;
+    const std::function< void() > _loop;
+    std::mutex _mutex;
+    std::condition_variable _suspended;
+    std::vector< ctx::fiber > _threadStacks;
+    std::vector< ctx::fiber > _idleFibers;
+};
+
+/** Resumes a suspended executable through the executable queues */
+class ResumeExecutable : public Executable
+{
+public:
+
+    ResumeExecutable( LoopContexts& contexts, const AwaitStatePtr& await )
+        : _contexts( contexts )
+        , _await( await )
+    {}
+
+    void execute() final { _contexts.resume( _await ); }
+    std::string getName() const final { return "Resume"; }
+    Futures getPostconditions() const final { return Futures(); }
+    Futures getPreconditions() const final { return Futures(); }
+    ExecutablePtr clone() const final
+    {
+        return ExecutablePtr( new ResumeExecutable( _contexts, _await ));
+    }
+
+private:
+
+    LoopContexts& _contexts;
+    const AwaitStatePtr _await;
+};
+
+#ifdef TUYAU_LOCKFREE_QUEUE
+typedef MPMCQueue< ExecutablePtr, 16384 > ExecutableQueue;
+#else
+typedef MTQueue< ExecutablePtr > ExecutableQueue;
+#endif
+
+template< size_t S >
+bool tryPushExecutable( MTQueue< ExecutablePtr, S >& queue,
+                        const ExecutablePtr& executable )
+{
+    queue.pushFront( executable );
+    return true;
+}
+
+template< size_t S >
+bool tryPushExecutable( MPMCQueue< ExecutablePtr, S >& queue,
+                        const ExecutablePtr& executable )
+{
+    return queue.tryPush( executable );
+}
+
+/**
+ * All threads share a single queue. The queue type is selected at compile time
+ * with TUYAU_LOCKFREE_QUEUE ( MPMCQueue ), otherwise MTQueue is used.
+ *
+ * When the bounded queue is full, the other threads block until there is
+ * room, but a worker cannot wait for the others, as they may be waiting to
+ * push, too. Its executables are kept in its overflow list, which it moves
+ * to the queue in order as the queue drains. The idle workers take from the
+ * overflow lists before waiting on the queue.
+ */
+class SharedWorkQueue : public WorkQueue
+{
+public:
+
+    explicit SharedWorkQueue( const size_t nThreads )
+        : _nThreads( nThreads )
+        , _overflows( new Overflow[ nThreads ])
+        , _overflowSize( 0 )
+    {}
+
+    void push( const ExecutablePtr& executable ) final
+    {
+        const CurrentWorker& currentWorker = getCurrentWorker();
+        if( currentWorker.queue != this )
+        {
+            if( !tryPushExecutable( _workQueue, executable ))
+                _workQueue.push( executable );
+            return;
+        }
+
+        // The executables of the overflow list go first to keep the order
+        Overflow& overflow = _overflows[ currentWorker.threadIndex ];
+        if( _overflowSize > 0 )
+            moveOverflow( overflow );
+
+        if( _overflowSize == 0 && tryPushExecutable( _workQueue, executable ))
+            return;
+
+        std::lock_guard< std::mutex > lock( overflow.mutex );
+        overflow.executables.push_back( executable );
+        ++_overflowSize;
+    }
+
+    /**
+     * On stop, each thread takes one of the empty executables pushed by
+     * stop(), which also wakes it up. The thread returns it once the queue and
+     * the overflow lists are drained. Otherwise it puts it back and executes
+     * the remaining executables first, including the ones that the other
+     * workers push after the stop.
+     */
+    ExecutablePtr pop( const size_t threadIndex ) final
+    {
+        const ExecutablePtr executable = takeExecutable( threadIndex );
+        if( executable )
+            return executable;
+
+        ExecutablePtr next;
+        if( !_workQueue.tryPop( next ) && !takeOverflows( threadIndex, next ))
+            return executable;
+
+        // The next executable may be the empty one of another thread, then
+        // one of both is returned, the other one is put back
+        _workQueue.push( executable );
+        return next;
+    }
+
+    void stop() final
+    {
+        for( size_t i = 0; i < _nThreads; ++i )
+            _workQueue.push( ExecutablePtr( ));
+    }
+
+private:
+
+    struct Overflow
+    {
+        std::mutex mutex;
+        std::deque< ExecutablePtr > executables;
+    };
+
+    /** Moves the executables of the overflow list to the queue in order */
+    void moveOverflow( Overflow& overflow )
+    {
+        std::lock_guard< std::mutex > lock( overflow.mutex );
+        while( !overflow.executables.empty() &&
+               tryPushExecutable( _workQueue, overflow.executables.front( )))
+        {
+            overflow.executables.pop_front();
+            --_overflowSize;
+        }
+    }
+
+    ExecutablePtr takeExecutable( const size_t threadIndex )
+    {
+        if( _overflowSize > 0 )
+        {
+            moveOverflow( _overflows[ threadIndex ]);
+
+            ExecutablePtr executable;
+            if( _workQueue.tryPop( executable ) ||
+                takeOverflows( threadIndex, executable ))
+            {
+                return executable;
+            }
+        }
+        return _workQueue.pop();
+    }
+
+    bool takeOverflows( const size_t threadIndex, ExecutablePtr& executable )
+    {
+        for( size_t i = 0; i < _nThreads; ++i )
+        {
+            Overflow& overflow = _overflows[( threadIndex + i ) % _nThreads ];
+            if( takeOverflow( overflow, executable ))
+                return true;
+        }
+        return false;
+    }
+
+    bool takeOverflow( Overflow& overflow, ExecutablePtr& executable )
+    {
+        std::lock_guard< std::mutex > lock( overflow.mutex );
+        if( overflow.executables.empty( ))
+            return false;
+
+        executable = overflow.executables.front();
+        overflow.executables.pop_front();
+        --_overflowSize;
+        return true;
+    }
+
+    const size_t _nThreads;
+    ExecutableQueue _workQueue;
+    std::unique_ptr< Overflow[] > _overflows;
+    std::atomic< size_t > _overflowSize;
+};
+
+/**
+ * Each thread has its own deque, or shares a deque with the threads of its
+ * NUMA node. The executables pushed from a worker thread ( i.e. the consumers
+ * that are ready after the worker set their inputs ) are pushed to the deque
+ * of that worker, the others are distributed round robin. The workers pop from
+ * the back of their deque and the idle workers steal from the front of the
+ * other deques.
+ */
+class WorkStealingQueue : public WorkQueue
+{
+public:
+
+    /**
+     * @param nDeques the number of deques
+     * @param threadDeques the deque index of each thread
+     */
+    WorkStealingQueue( const size_t nDeques,
+                       const std::vector< size_t >& threadDeques )
+        : _threadDeques( threadDeques )
+        , _pending( 0 )
+        , _sleepers( 0 )
+        , _next( 0 )
+        , _stopped( false )
+    {
+        for( size_t i = 0; i < nDeques; ++i )
+            _deques.emplace_back( new Deque );
+    }
+
+    void push( const ExecutablePtr& executable ) final
+    {
+        const CurrentWorker& currentWorker = getCurrentWorker();
+        const size_t index = currentWorker.queue == this
+                           ? _threadDeques[ currentWorker.threadIndex ]
+                           : _next++ % _deques.size();
+        {
+            Deque& deque = *_deques[ index ];
+            std::lock_guard< std::mutex > lock( deque.mutex );
+            deque.executables.push_back( executable );
+        }
+
+        ++_pending;
+        if( _sleepers > 0 )
+        {
+            std::lock_guard< std::mutex > lock( _parkMutex );
+            _parkCondition.notify_one();
+        }
+    }
+
+    ExecutablePtr pop( const size_t threadIndex ) final
+    {
+        while( true )
+        {
+            const size_t index = _threadDeques[ threadIndex ];
+            ExecutablePtr executable = popLocal( index );
+            if( !executable )
+                executable = steal( index );
+
+            if( executable )
+            {
+                --_pending;
+                return executable;
+            }
+
+            std::unique_lock< std::mutex > lock( _parkMutex );
+            if( _stopped && _pending == 0 )
+                return ExecutablePtr();
+
+            ++_sleepers;
+            _parkCondition.wait( lock, [ & ]{ return _pending > 0 || _stopped; });
+            --_sleepers;
+        }
+    }
+
+    void stop() final
+    {
+        std::lock_guard< std::mutex > lock( _parkMutex );
+        _stopped = true;
+        _parkCondition.notify_all();
+    }
+
+private:
+
+    ExecutablePtr popLocal( const size_t index )
+    {
+        Deque& deque = *_deques[ index ];
+        std::lock_guard< std::mutex > lock( deque.mutex );
+        if( deque.executables.empty( ))
+            return ExecutablePtr();
+
+        const ExecutablePtr executable = deque.executables.back();
+        deque.executables.pop_back();
+        return executable;
+    }
+
+    ExecutablePtr steal( const size_t index )
+    {
+        for( size_t i = 1; i < _deques.size(); ++i )
+        {
+            Deque& deque = *_deques[ ( index + i ) % _deques.size() ];
+            std::lock_guard< std::mutex > lock( deque.mutex );
+            if( deque.executables.empty( ))
+                continue;
+
+            const ExecutablePtr executable = deque.executables.front();
+            deque.executables.pop_front();
+            return executable;
+        }
+        return ExecutablePtr();
+    }
+
+    struct Deque
+    {
+        std::mutex mutex;
+        std::deque< ExecutablePtr > executables;
+    };
+
+    const std::vector< size_t > _threadDeques;
+    std::vector< std::unique_ptr< Deque >> _deques;
+    std::atomic< size_t > _pending;
+    std::atomic< size_t > _sleepers;
+    std::atomic< size_t > _next;
+    bool _stopped;
+    std::mutex _parkMutex;
+    std::condition_variable _parkCondition;
+};
+
+/** Records the time the executable waits in the queue, when tracing */
+class QueuedExecutable : public Executable
+{
+public:
+
+    explicit QueuedExecutable( const ExecutablePtr& executable )
+        : _executable( executable )
+        , _enqueueTime( Trace::now( ))
+    {}
+
+    void execute() final
+    {
+        Trace::complete( "queue", _executable->getName(), _enqueueTime, Trace::now( ));
+        _executable->execute();
+    }
+
+    std::string getName() const final { return _executable->getName(); }
+    size_t getEstimatedOutputSize() const final { return _executable->getEstimatedOutputSize(); }
+    int getPriority() const final { return _executable->getPriority(); }
+    Futures getPostconditions() const final { return _executable->getPostconditions(); }
+    Futures getPreconditions() const final { return _executable->getPreconditions(); }
+    ExecutablePtr clone() const final { return _executable->clone(); }
+
+private:
+
+    const ExecutablePtr _executable;
+    const uint64_t _enqueueTime;
+};
+
+/** Runs a task through the executable queues */
+class TaskExecutable : public Executable
+{
+public:
+
+    explicit TaskExecutable( const WorkerTask& task )
+        : _task( task )
+    {}
+
+    void execute() final { _task(); }
+    std::string getName() const final { return "Task"; }
+    Futures getPostconditions() const final { return Futures(); }
+    Futures getPreconditions() const final { return Futures(); }
+    ExecutablePtr clone() const final
+    {
+        return ExecutablePtr( new TaskExecutable( _task ));
+    }
+
+private:
+
+    const WorkerTask _task;
+};
+
+/** The placement of a worker thread */
+struct ThreadPlacement
+{
+    size_t node; //!< The NUMA node of the thread
+    Workers::Cores cores; //!< The cores the thread is bound to, empty if not bound
+};
+
+typedef std::vector< ThreadPlacement > ThreadPlacements;
+
+/**
+ * @param cpuList is a list of cores in the sysfs format, i.e. "0-3,8,10-11"
+ * @return the cores in the list
+ */
+Workers::Cores parseCpuList( const std::string& cpuList )
+{
+    Workers::Cores cores;
+    std::istringstream stream( cpuList );
+    std::string range;
+    while( std::getline( stream, range, ',' ))
+    {
+        if( range.empty( ))
+            continue;
+
+        const size_t dash = range.find( '-' );
+        const size_t first = std::stoul( range.substr( 0, dash ));
+        const size_t last = dash == std::string::npos
+                          ? first : std::stoul( range.substr( dash + 1 ));
+        for( size_t core = first; core <= last; ++core )
+            cores.push_back( core );
+    }
+    return cores;
+}
+
+ThreadPlacements placeThreads( const size_t nThreads,
+                               const Workers::QueueMode queueMode,
+                               const Workers::Cores& cores )
+{
+    const std::vector< Workers::Cores >& nodes = queueMode == Workers::NUMA_NODES
+                                               ? Workers::getNumaNodes()
+                                               : std::vector< Workers::Cores >();
+    ThreadPlacements placements( nThreads );
+    for( size_t i = 0; i < nThreads; ++i )
+    {
+        ThreadPlacement& placement = placements[ i ];
+        placement.node = 0;
+        if( !cores.empty( ))
+        {
+            const size_t core = cores[ i % cores.size() ];
+            placement.cores.push_back( core );
+            for( size_t node = 0; node < nodes.size(); ++node )
+            {
+                if( std::find( nodes[ node ].begin(), nodes[ node ].end(), core )
+                        != nodes[ node ].end( ))
+                {
+                    placement.node = node;
+                }
+            }
+        }
+        else if( !nodes.empty( ))
+        {
+            placement.node = i % nodes.size();
+            placement.cores = nodes[ placement.node ];
+        }
+    }
+    return placements;
+}
+
+WorkQueue* createWorkQueue( const Workers::QueueMode queueMode,
+                            const ThreadPlacements& placements )
+{
+    const size_t nThreads = placements.size();
+    switch( queueMode )
+    {
+    case Workers::WORK_STEALING:
+    {
+        std::vector< size_t > threadDeques( nThreads );
+        for( size_t i = 0; i < nThreads; ++i )
+            threadDeques[ i ] = i;
+        return new WorkStealingQueue( nThreads, threadDeques );
+    }
+    case Workers::NUMA_NODES:
+    {
+        std::vector< size_t > threadDeques( nThreads );
+        for( size_t i = 0; i < nThreads; ++i )
+            threadDeques[ i ] = placements[ i ].node;
+        return new WorkStealingQueue( Workers::getNumaNodes().size(), threadDeques );
+    }
+    case Workers::SHARED_QUEUE:
+    default:
+        return new SharedWorkQueue( nThreads );
+    }
+}
+
+/**
+ * Binds the current thread to the given cores and names it for the profilers
+ * and debuggers ( the names are truncated to 15 characters by the system, so
+ * the pool name is shortened to keep the thread index ).
+ */
+void setupThread( const std::string& poolName,
+                  const size_t threadIndex,
+                  const Workers::Cores& cores )
+{
+#ifdef __linux__
+    const std::string index = " " + std::to_string( threadIndex );
+    const size_t maxNameSize = 15;
+    const std::string name = poolName.substr( 0, maxNameSize - std::min( maxNameSize,
+                                                                         index.size( )))
+                           + index;
+    pthread_setname_np( pthread_self(), name.substr( 0, maxNameSize ).c_str( ));
+
+    if( cores.empty( ))
+        return;
+
+    cpu_set_t cpuSet;
+    CPU_ZERO( &cpuSet );
+    for( const size_t core: cores )
+    {
+        if( core < CPU_SETSIZE )
+            CPU_SET( core, &cpuSet );
+    }
+    pthread_setaffinity_np( pthread_self(), sizeof( cpuSet ), &cpuSet );
+#else
+    (void)poolName;
+    (void)threadIndex;
+    (void)cores;
+#endif
+}
+
+}
+
 struct Workers::Impl
 {
     Impl( Workers& workers,
           const size_t nThreads,
           const std::string& threadPoolName,
           const WorkerSetupFunc& setupFunc,
-          const WorkerDestroyFunc& destroyFunc )
+          const WorkerDestroyFunc& destroyFunc,
+          const QueueMode queueMode,
+          const Cores& cores,
+          const size_t fiberStackSize )
         : _workers( workers )
+        , _placements( placeThreads( nThreads, queueMode, cores ))
+        , _workQueue( createWorkQueue( queueMode, _placements ))
         , _name( threadPoolName )
         , _setupFunc( setupFunc )
         , _destroyFunc( destroyFunc )
+        , _contexts( nThreads, fiberStackSize, [ this ]{ runLoop(); })
     {
         for( size_t i = 0; i < nThreads; ++i )
-            _threadGroup.create_thread( boost::bind( &Impl::execute, this ));
+            _threadGroup.create_thread( boost::bind( &Impl::execute, this, i ));
     }
 
-    void execute()
+    void execute( const size_t threadIndex )
     {
+        Trace::setThreadName( _name + " " + std::to_string( threadIndex ));
+        setupThread( _name, threadIndex, _placements[ threadIndex ].cores );
         if( _setupFunc )
             _setupFunc();
 
+        getCurrentWorker() = { &_workers, _workQueue.get(), threadIndex, threadIndex, false };
+        runLoop();
+        getCurrentWorker() = { nullptr, nullptr, 0, fiberStack, false };
+
+        if( _destroyFunc )
+            _destroyFunc();
+    }
+
+    /**
+     * Executes the executables of the queue until it stops, then returns on
+     * the stack of the thread, or in a fiber, which switches to the stack of
+     * the thread once it is free ( see LoopContexts ).
+     */
+    void runLoop()
+    {
         while( true )
         {
-            ExecutablePtr exec = _workQueue.pop();
-            if( !exec )
-                break;
+            CurrentWorker& currentWorker = getCurrentWorker();
+            if( currentWorker.stopped )
+            {
+                if( currentWorker.stack == currentWorker.threadIndex ||
+                    currentWorker.stack == fiberStack )
+                {
+                    return;
+                }
 
-            exec->execute();
+                // The stack of another thread, which waits to take it back
+                _contexts.yield();
+                continue;
+            }
+
+            const ExecutablePtr exec = _workQueue->pop( currentWorker.threadIndex );
+            if( exec )
+                exec->execute();
+            else
+                currentWorker.stopped = true;
         }
+    }
 
-        if( _destroyFunc )
-            _destroyFunc();
+    void await( const AsyncStartFunc& start )
+    {
+        const AwaitStatePtr await = std::make_shared< AwaitState >( start );
+        _contexts.await( await, [ this, await ]{ resume( await ); });
+        if( await->exception )
+            std::rethrow_exception( await->exception );
+    }
+
+    void resume( const AwaitStatePtr& await )
+    {
+        if( !await->resumed.exchange( true ))
+            _workQueue->push( std::make_shared< ResumeExecutable >( _contexts, await ));
     }
 
     ~Impl()
     {
-        for( size_t i = 0; i < getSize(); ++i )
-            _workQueue.push( ExecutablePtr( ));
+        _workQueue->stop();
         _threadGroup.join_all();
     }
 
 
     void submitWork( ExecutablePtr executable )
     {
-        _workQueue.pushFront( executable );
+        if( Trace::isEnabled( ))
+            _workQueue->push( std::make_shared< QueuedExecutable >( executable ));
+        else
+            _workQueue->push( executable );
     }
 
     size_t getSize() const
@@ -79,22 +859,30 @@ struct Workers::Impl
     }
 
     Workers& _workers;
-    MTQueue< ExecutablePtr > _workQueue;
+    const ThreadPlacements _placements;
+    std::unique_ptr< WorkQueue > _workQueue;
     boost::thread_group _threadGroup;
     const std::string _name;
     const WorkerSetupFunc _setupFunc;
     const WorkerDestroyFunc _destroyFunc;
+    LoopContexts _contexts;
 };
 
 Workers::Workers( const size_t nThreads,
                   const std::string& threadPoolName,
                   const WorkerSetupFunc& setupFunc,
-                  const WorkerDestroyFunc& destroyFunc )
+                  const WorkerDestroyFunc& destroyFunc,
+                  const QueueMode queueMode,
+                  const Cores& cores,
+                  const size_t fiberStackSize )
     : _impl( new Workers::Impl( *this,
                                 nThreads,
                                 threadPoolName,
                                 setupFunc,
-                                destroyFunc ))
+                                destroyFunc,
+                                queueMode,
+                                cores,
+                                fiberStackSize ))
 {}
 
 Workers::~Workers()
@@ -105,9 +893,85 @@ void Workers::schedule( ExecutablePtr executable )
     _impl->submitWork( executable );
 }
 
+void Workers::submit( const WorkerTask& task )
+{
+    _impl->submitWork( std::allocate_shared< TaskExecutable >(
+                           PoolAllocator< TaskExecutable >(), task ));
+}
+
 size_t Workers::getSize() const
 {
     return _impl->getSize();
 }
 
+Workers* Workers::getCurrent()
+{
+    return getCurrentWorker().workers;
+}
+
+void Workers::await( const Future& future )
+{
+    if( future.isReady( ))
+        return;
+
+    await( [ future ]( const WorkerTask& resume ){ future.onReady( resume ); });
+}
+
+void Workers::await( const AsyncStartFunc& start )
+{
+    Workers* workers = getCurrentWorker().workers;
+    if( !workers )
+    {
+        // Out of the worker threads, the thread blocks
+        struct Completion
+        {
+            std::mutex mutex;
+            std::condition_variable condition;
+            bool done = false;
+        };
+
+        const auto completion = std::make_shared< Completion >();
+        start( [ completion ]
+        {
+            std::lock_guard< std::mutex > lock( completion->mutex );
+            completion->done = true;
+            completion->condition.notify_all();
+        });
+
+        std::unique_lock< std::mutex > lock( completion->mutex );
+        completion->condition.wait( lock, [ & ]{ return completion->done; });
+        return;
+    }
+
+    workers->_impl->await( start );
+}
+
+std::vector< Workers::Cores > Workers::getNumaNodes()
+{
+    static const std::vector< Cores > nodes = []
+    {
+        std::vector< Cores > numaNodes;
+        for( size_t node = 0; ; ++node )
+        {
+            std::ifstream file( "/sys/devices/system/node/node" +
+                                std::to_string( node ) + "/cpulist" );
+            std::string cpuList;
+            if( !file || !std::getline( file, cpuList ))
+                break;
+
+            numaNodes.push_back( parseCpuList( cpuList ));
+        }
+
+        if( numaNodes.empty( ))
+        {
+            Cores cores( std::max( 1u, std::thread::hardware_concurrency( )));
+            for( size_t i = 0; i < cores.size(); ++i )
+                cores[ i ] = i;
+            numaNodes.push_back( cores );
+        }
+        return numaNodes;
+    }();
+    return nodes;
+}
+
 }
@@ -33,17 +33,48 @@ class Workers
 {
 public:
 
+    /**
+     * The way the executables are distributed to the threads.
+     */
+    enum QueueMode
+    {
+        SHARED_QUEUE, //!< All threads pop from a single queue
+        WORK_STEALING, //!< Each thread has a deque, idle threads steal from others
+        NUMA_NODES //!< Each NUMA node has a deque shared by the threads on the node
+    };
+
+    /** List of logical core ( CPU ) indices */
+    typedef std::vector< size_t > Cores;
+
     /**
      * Constructs a thread pool given the number of threads.
      * @param nThreads is the number of threads.
      * @param threadPoolName the threads are renamed with the given name
      * @param setupFunc setups the workers before executing the work loop
      * (i.e. setCurrent() with OpenGL)
+     * @param destroyFunc is called by the workers after the work loop
+     * @param queueMode the distribution of executables to the threads. In the
+     * WORK_STEALING mode, the executables scheduled from a worker thread are
+     * executed preferably by the same thread. In the NUMA_NODES mode, the
+     * threads are distributed to the NUMA nodes round robin and bound to the
+     * cores of their node. The executables scheduled from a worker thread,
+     * i.e. the consumers of the data produced ( and allocated ) on the node,
+     * are executed preferably on the same node.
+     * @param cores the threads are pinned to the given cores round robin, in
+     * the NUMA_NODES mode a thread belongs to the node of its core. If empty,
+     * the threads are not pinned.
+     * @param fiberStackSize the stack size of the fibers, which run the loop
+     * of a thread while an executable awaits ( see await( )). The fibers are
+     * created on the first awaits and the executables resumed after an await
+     * may run on them, so the size has to fit the executables.
      */
     TUYAU_API Workers( size_t nThreads = 4,
                        const std::string& threadPoolName = "Workers",
                        const WorkerSetupFunc& setupFunc = WorkerSetupFunc(),
-                       const WorkerSetupFunc& destroyFunc = WorkerDestroyFunc());
+                       const WorkerSetupFunc& destroyFunc = WorkerDestroyFunc(),
+                       QueueMode queueMode = SHARED_QUEUE,
+                       const Cores& cores = Cores(),
+                       size_t fiberStackSize = 1024 * 1024 );
     TUYAU_API ~Workers();
 
     /**
@@ -52,11 +83,50 @@ public:
      */
     TUYAU_API void schedule( ExecutablePtr executable );
 
+    /**
+     * Submitted task is scheduled to the execution queue.
+     * @param task is executed by thread pool.
+     */
+    TUYAU_API void submit( const WorkerTask& task );
+
     /**
      * @return the size of thread pool.
      */
     TUYAU_API size_t getSize() const;
 
+    /**
+     * @return the cores of the NUMA nodes of the system, a single node with
+     * all cores if the NUMA topology is not available
+     */
+    TUYAU_API static std::vector< Cores > getNumaNodes();
+
+    /**
+     * @return the workers of the current worker thread, nullptr out of the
+     * worker threads
+     */
+    TUYAU_API static Workers* getCurrent();
+
+    /**
+     * Suspends the executable running on the current worker thread until the
+     * future is ready. Meanwhile the thread executes other executables, and
+     * the executable resumes on any free thread of the workers. Out of the
+     * worker threads, blocks until the future is ready. As the executable may
+     * resume on another thread, it should not hold locks or thread local data
+     * across the call.
+     * @param future is waited for
+     */
+    TUYAU_API static void await( const Future& future );
+
+    /**
+     * Suspends the executable running on the current worker thread until an
+     * asynchronous operation, i.e. I/O, completes ( see await( const Future& )).
+     * The operation must complete before the workers are destroyed.
+     * @param start starts the operation with the completion callback, which
+     * has to be called once when the operation completes, from any thread.
+     * @throw the exception thrown by start
+     */
+    TUYAU_API static void await( const AsyncStartFunc& start );
+
 private:
 
     struct Impl;